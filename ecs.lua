@@ -30,6 +30,11 @@ local ecs_term_t = {}
 ---@field expr string
 local ecs_filter_t = {}
 
+---@class ecs_query_desc_t : ecs_filter_t
+---@field order_by table @{component, member: string} or {component, fun(e1, c1, e2, c2): number}
+---@field group_by integer @relationship, tables are grouped by its target
+local ecs_query_desc_t = {}
+
 ---@class ecs_query_t
 local ecs_query_t = {}
 
@@ -49,6 +54,8 @@ local ecs_snapshot_t = {}
 ---@field delta_system_time number
 ---@field interrupted_by integer
 ---@field term_index integer
+---@field group_id integer
+---@field changed boolean @whether the current table of a query iterator changed since it was last iterated
 local ecs_iter_t = {}
 
 ---Create a new entity
@@ -126,7 +133,8 @@ end
 function ecs.fullpath(entity)
 end
 
----Look up an entity by name
+---Look up an entity by name, lookups from the root scope are cached
+---until names, aliases or the hierarchy change (also applies to the other lookup functions)
 ---@param name string
 ---@return integer
 function ecs.lookup(name)
@@ -445,6 +453,13 @@ end
 function ecs.array(name, type, count)
 end
 
+---Create a vector component
+---@param name string name
+---@param type integer @element type
+---@return integer @entity
+function ecs.vector(name, type)
+end
+
 ---Create a struct component
 ---@param name string name
 ---@param descriptor string @format: "{type member; ...}"
@@ -538,12 +553,30 @@ end
 function ecs.prefab(name, signature)
 end
 
----Get child count, NOTE: creates a temporary iterator!
+---Get child count, includes prefab and disabled children
 ---@param entity integer
 ---@return integer
 function ecs.get_child_count(entity)
 end
 
+---Get the children of an entity, includes prefab and disabled children
+---@param entity integer
+---@return integer[]
+function ecs.children(entity)
+end
+
+---@class ecs_descendants_desc_t
+---@field depth_first boolean @pre-order instead of breadth-first
+---@field max_depth integer @1 returns the children only
+local ecs_descendants_desc_t = {}
+
+---Get all descendants of an entity, includes prefab and disabled descendants
+---@param entity integer
+---@param desc ecs_descendants_desc_t @optional
+---@return integer[]
+function ecs.descendants(entity, desc)
+end
+
 ---Set the current scope, returns previous scope
 ---@param scope integer
 ---@return integer
@@ -607,8 +640,19 @@ end
 function ecs.column_entity(it, column)
 end
 
----Create a filter iterator
----@param filter ecs_filter_t
+---@class ecs_filter_handle_t
+local ecs_filter_handle_t = {}
+
+---Compile a filter, it is freed when the object is collected
+---@param filter ecs_filter_t|string
+---@return ecs_filter_handle_t
+function ecs.filter(filter)
+end
+
+---Create a filter iterator, filters passed as descriptors or
+---expressions are compiled once and cached by expression or table identity,
+---descriptor tables must not be modified afterwards
+---@param filter ecs_filter_handle_t|ecs_filter_t|string
 ---@return ecs_iter_t
 function ecs.filter_iter(filter)
 end
@@ -637,23 +681,57 @@ end
 function ecs.iter_next(it)
 end
 
+---Create an iterator that limits the results of another iterator
+---@param it ecs_iter_t @source iterator, it must not be progressed directly
+---@param offset integer
+---@param limit integer
+---@return ecs_iter_t
+function ecs.page(it, offset, limit)
+end
+
+---Progress the page iterator
+---@param it ecs_iter_t
+---@return boolean
+function ecs.page_next(it)
+end
+
+---Create an iterator that returns the index-th part of the results
+---of another iterator split count ways
+---@param it ecs_iter_t @source iterator, it must not be progressed directly
+---@param index integer @0-based
+---@param count integer
+---@return ecs_iter_t
+function ecs.worker(it, index, count)
+end
+
+---Progress the worker iterator
+---@param it ecs_iter_t
+---@return boolean
+function ecs.worker_next(it)
+end
+
 ---Create a query
----@param desc ecs_filter_t|string
+---NOTE: order_by sorts by a primitive member of the component natively,
+---comparator functions are called while the query is iterated and must
+---not modify the world.
+---@param desc ecs_query_desc_t|string
 ---@return ecs_query_t
 function ecs.query(desc)
 end
 
 ---Create a subquery
 ---@param query ecs_query_t
----@param desc ecs_filter_t|string
+---@param desc ecs_query_desc_t|string
 ---@return ecs_query_t
 function ecs.subquery(query, desc)
 end
 
 ---Create a query iterator
+---@overload fun(query: ecs_query_t)
 ---@param query ecs_query_t
+---@param options table @{group = integer, changed = boolean}, group iterates a single group of a group_by query, changed skips tables that did not change
 ---@return ecs_iter_t
-function ecs.query_iter(query)
+function ecs.query_iter(query, options)
 end
 
 ---Progress the query iterator
@@ -671,28 +749,111 @@ end
 ---Create generic for loop iterator for a query/iterator
 ---NOTE: Jumping out of the loop will leave the last iteration's
 ---components unmodified.
+---Queries reuse their iteration state between loops, on Lua 5.3 a loop
+---that was exited early keeps it busy and later loops allocate a new state.
 ---@overload fun(it: ecs_iter_t)
+---@overload fun(query: ecs_query_t)
 ---@param query ecs_query_t
-function ecs.each(query)
+---@param options table @{changed = boolean}, skip tables that did not change
+function ecs.each(query, options)
 end
 
+---@class ecs_system_opts_t
+---@field cache_columns boolean @optional, share read-only ([in]) column tables with other systems within a frame,
+---the shared tables cannot be modified and writes by C systems are not detected
+---@field changed_only boolean @optional, skip tables that did not change since the system last ran,
+---run systems skip them in ecs.iter_next()
+---@field run boolean @optional, call the function once per run, it iterates the tables with ecs.iter_next()
+local ecs_system_opts_t = {}
+
 ---Create a system
 ---@overload fun(callback: function, name: string, phase: integer)
 ---@param callback fun(it: ecs_iter_t)
 ---@param name string
 ---@param phase integer
 ---@param query string|ecs_filter_t @optional
+---@param options ecs_system_opts_t @optional
 ---@return integer @entity
-function ecs.system(callback, name, phase, query)
+function ecs.system(callback, name, phase, query, options)
 end
 
----Create an observer
----@param callback fun(it: ecs_iter_t)
+---Create one system that calls the functions in order with the same
+---iterator, columns are serialized once per table and written back
+---after the last function
+---@param name string
+---@param phase integer
+---@param query string|ecs_filter_t
+---@param callbacks fun(it: ecs_iter_t)[]
+---@return integer @entity
+function ecs.system_group(name, phase, query, callbacks)
+end
+
+---@class ecs_observer_batch_t
+---@field count integer
+---@field entities integer[]
+---@field events integer[]
+---@field ids integer[]
+---@field groups table[] @{first, count} ranges of records from the same table
+local ecs_observer_batch_t = {}
+
+---@class ecs_observer_options_t
+---@field batch boolean|integer @queue events and deliver them once per frame (PostFrame) or in the given phase
+local ecs_observer_options_t = {}
+
+---Create an observer, batched observers are called with an ecs_observer_batch_t
+---@param callback fun(it: ecs_iter_t)|fun(batch: ecs_observer_batch_t)
 ---@param name string
 ---@param events integer|integer[]
 ---@param filter ecs_filter_t|string
+---@param options ecs_observer_options_t @optional
 ---@return integer @entity
-function ecs.observer(callback, name, events, filter)
+function ecs.observer(callback, name, events, filter, options)
+end
+
+---Emit an event, observers are invoked once per table range
+---and receive the payload as it.payload
+---@param event integer|integer[]
+---@param ids integer|integer[]
+---@param target integer|integer[]|ecs_iter_t @entity, entities or the current table range of an iterator
+---@param payload any @optional, the event must be a component
+function ecs.emit(event, ids, target, payload)
+end
+
+---@class ecs_vector_view_t
+---view[i] returns a proxy for struct elements, view[i].field = value writes
+---to the vector, other elements are returned by value.
+---view[i] = value replaces an element, view[#view + 1] appends
+local ecs_vector_view_t = {}
+
+---Return a copy of an element
+---@param i integer
+---@return table
+function ecs_vector_view_t:get(i)
+end
+
+---Append an element, returns the new length
+---@param value table @optional
+---@return integer
+function ecs_vector_view_t:push(value)
+end
+
+---Remove and return the last element
+---@return table
+function ecs_vector_view_t:pop()
+end
+
+---Resize the vector, new elements are default initialized
+---@param size integer
+function ecs_vector_view_t:resize(size)
+end
+
+---Create a view over a vector (member) of a component,
+---accessing the view does not copy the whole vector
+---@param entity integer
+---@param component integer
+---@param member string @optional, dot-separated path of the vector member
+---@return ecs_vector_view_t
+function ecs.vector_view(entity, component, member)
 end
 
 ---Run a specific system manually
@@ -779,6 +940,23 @@ end
 function ecs.tracing_enable(level)
 end
 
+---@class ecs_log_opts_t
+---@field capacity integer @optional, buffered messages (default 1024)
+---@field rate integer @optional, messages per second per call site, 0 is unlimited (default)
+local ecs_log_opts_t = {}
+
+---Redirect ecs.log/err/dbg/warn to a file, messages are buffered
+---and written on a separate thread, they are dropped if the buffer is full
+---@param path string
+---@param opts ecs_log_opts_t @optional
+function ecs.log_open(path, opts)
+end
+
+---Flush and close the log file
+---@return integer|nil @dropped message count
+function ecs.log_close()
+end
+
 ---Enable or disable tracing with colors
 ---@param enable boolean
 function ecs.log_enable_colors(enable)
@@ -904,6 +1082,83 @@ end
 function ecs.set_tick_source(system, tick_source)
 end
 
+---Call a function once after a delay, timers are kept in a timer wheel
+---with 1ms resolution instead of timer entities
+---@param seconds number
+---@param fn fun(timer: integer)
+---@return integer @timer handle
+function ecs.after(seconds, fn)
+end
+
+---Call a function every interval, intervals missed during a long frame
+---are caught up in the same frame
+---@param seconds number
+---@param fn fun(timer: integer)
+---@return integer @timer handle
+function ecs.every(seconds, fn)
+end
+
+---Cancel a timer created by ecs.after() or ecs.every()
+---@param timer integer
+---@return boolean @false if the timer already expired or was cancelled
+function ecs.cancel(timer)
+end
+
+---@class ecs_shard_stats_t
+---@field frames integer
+---@field frame_time_total number
+---@field frame_time_last number
+---@field frame_time_max number
+---@field running boolean @false after ecs.quit() in the shard
+local ecs_shard_stats_t = {}
+
+---Create a world with its own Lua state, run the script in it and
+---progress the world on the shard thread pool
+---@param path string @script
+---@param delta_time number @optional, measured if 0 (default), frames are paced to it
+---@return integer @shard id
+function ecs.shard_start(path, delta_time)
+end
+
+---Stop a shard and destroy its world, waits for the current frame
+---unless called from a shard, then the shard stops after its frame
+---@param shard integer
+function ecs.shard_stop(shard)
+end
+
+---Get the frame stats of a shard
+---@param shard integer
+---@return ecs_shard_stats_t|nil
+function ecs.shard_stats(shard)
+end
+
+---@class ecs_channel_t
+local ecs_channel_t = {}
+
+---Queue a copy of the value, returns false if the channel is full
+---@param value table
+---@return boolean
+function ecs_channel_t:send(value)
+end
+
+---Call fn for each queued value, oldest first. The same table is
+---passed for every value, only one Lua state may drain a channel
+---@param fn fun(value: table)
+---@param max integer @optional
+---@return integer @number of values
+function ecs_channel_t:drain(fn, max)
+end
+
+---Open or create a named channel shared by all worlds and Lua states
+---of the process, values are copied as raw bytes of a struct type
+---without hooks, the type is matched by path between worlds
+---@param name string
+---@param type integer
+---@param capacity integer @optional, used when the channel is created (default 1024)
+---@return ecs_channel_t
+function ecs.channel(name, type, capacity)
+end
+
 ---Create a new pipeline
 ---@param name string
 ---@param expr string
@@ -1093,6 +1348,61 @@ end
 function ecs.world_stats()
 end
 
+---@class ecs_world_stats_view_t
+---Stats are read lazily by name, e.g. view.entity_count
+---@field t integer @index of the latest sample
+local ecs_world_stats_view_t = {}
+
+---Record a new sample
+---@return ecs_world_stats_view_t
+function ecs_world_stats_view_t:update()
+end
+
+---Create a world stats view, in latest mode fields return the latest
+---gauge average or counter value instead of an EcsLuaGauge/EcsLuaCounter table
+---@param latest boolean @optional
+---@return ecs_world_stats_view_t
+function ecs.world_stats_view(latest)
+end
+
+---Periodically write world stats, world info and Lua system timings
+---to a file in the Prometheus text format, nil stops the exporter
+---@param path string|nil
+---@param interval number @optional, seconds (default 1)
+function ecs.export_stats(path, interval)
+end
+
+---@class ecs_profiler_opts_t
+---@field interval_us integer @optional, sampling interval (default 1000)
+---@field count integer @optional, instructions between clock checks (default 1000)
+local ecs_profiler_opts_t = {}
+
+---Start the sampling profiler for the Lua state, samples are
+---aggregated by stack with the running system as the root frame
+---@param opts ecs_profiler_opts_t @optional
+function ecs.profiler_start(opts)
+end
+
+---Stop the profiler and write the samples as folded stacks,
+---returns the folded stacks as a string if path is nil
+---@param path string @optional
+---@return integer|string @sample count
+function ecs.profiler_stop(path)
+end
+
+---Start recording spans for Lua system calls, progress callbacks
+---and module imports, the oldest spans are overwritten when full
+---@param capacity integer @optional, spans (default 65536)
+function ecs.trace_start(capacity)
+end
+
+---Stop tracing and write the spans in the Chrome trace event format,
+---returns the JSON as a string if path is nil
+---@param path string @optional
+---@return integer|string @span count
+function ecs.trace_stop(path)
+end
+
 ---Dimension the world for a specified number of entities
 ---@param count integer entity
 function ecs.dim(count)
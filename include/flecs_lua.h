@@ -15,6 +15,22 @@ typedef struct EcsLuaHost
     ecs_lua_ctx *ctx;
 }EcsLuaHost;
 
+typedef struct ecs_lua_cache_stats_t
+{
+    int32_t hits;
+    int32_t misses;
+    int32_t errors; /* Bytecode that could not be written to the cache */
+}ecs_lua_cache_stats_t;
+
+typedef struct ecs_lua_shard_stats_t
+{
+    int64_t frames;
+    double frame_time_total;
+    double frame_time_last;
+    double frame_time_max;
+    bool running; /* false after ecs_quit() or ecs_lua_shard_stop() */
+}ecs_lua_shard_stats_t;
+
 FLECS_LUA_API
 void FlecsLuaImport(ecs_world_t *w);
 
@@ -65,6 +81,47 @@ ecs_iter_t *ecs_iter_to_lua(ecs_iter_t *it, lua_State *L, bool copy);
 FLECS_LUA_API
 ecs_iter_t *ecs_lua_to_iter(lua_State *L, int idx);
 
+/* Load a Lua file as a function on top of the stack, like luaL_loadfile().
+   Compiled chunks are stored in cache_dir keyed by a hash of their contents,
+   unchanged files are loaded from bytecode. The cache is disabled if cache_dir is NULL,
+   LUA_ERRERR is returned if FlecsLua is not imported in the world */
+FLECS_LUA_API
+int ecs_lua_load_cached(ecs_world_t *world, const char *path, const char *cache_dir);
+
+/* Get the bytecode cache statistics for the world's Lua state */
+FLECS_LUA_API
+void ecs_lua_cache_stats(ecs_world_t *world, ecs_lua_cache_stats_t *stats);
+
+/* Periodically write world stats, world info and Lua system timings to path
+   in the Prometheus text format. Files are formatted and written on a separate
+   thread when the OS API supports it. A NULL path stops the exporter,
+   returns 0 on success */
+FLECS_LUA_API
+int ecs_lua_export_stats(ecs_world_t *world, const char *path, ecs_ftime_t interval);
+
+/* Set the number of threads of the shard pool, before the first shard is started */
+FLECS_LUA_API
+void ecs_lua_shard_threads(int32_t count);
+
+/* Progress the world on the shard thread pool until ecs_quit() is called or the shard is stopped.
+   The world must not be used by other threads and should have its own lua_State (ecs_lua_get_state()),
+   frames are paced to a non-zero delta_time, returns a shard id or 0 if the OS API has no threading support */
+FLECS_LUA_API
+int32_t ecs_lua_shard_start(ecs_world_t *world, ecs_ftime_t delta_time);
+
+/* Stop a shard, waits for the current frame to finish.
+   Called from a shard frame it returns immediately, the shard is stopped after its frame */
+FLECS_LUA_API
+void ecs_lua_shard_stop(int32_t shard);
+
+/* Get the frame stats of a shard, returns false for invalid or stopped shards */
+FLECS_LUA_API
+bool ecs_lua_shard_stats(int32_t shard, ecs_lua_shard_stats_t *stats);
+
+/* Stop all shards and the thread pool */
+FLECS_LUA_API
+void ecs_lua_shard_fini(void);
+
 /* Create an EmmyLua class annotation */
 FLECS_LUA_API
 char *ecs_type_to_emmylua(const ecs_world_t *world, ecs_entity_t type, bool struct_as_table);
@@ -0,0 +1,349 @@
+#include "private.h"
+
+/* Bounded multi-producer single-consumer queues of component values,
+   shared by name between worlds and Lua states of the process */
+
+typedef struct ecs_lua_channel_t
+{
+    struct ecs_lua_channel_t *next;
+    int32_t refs;
+
+    char *name;
+    char *type_path; /* Types are matched by path and layout across worlds */
+    char *layout;
+    ecs_size_t size;
+
+    int32_t mask;
+    int32_t head; /* Claimed by producers */
+    int32_t tail; /* Consumer */
+    int32_t count; /* Claimed and not yet consumed */
+    lua_State *consumer; /* Main thread of the state, guarded by the registry lock */
+
+    int32_t *ready; /* Published cells */
+    void *data;
+}ecs_lua_channel_t;
+
+/* Userdata of "ecs_channel_t" objects */
+typedef struct ecs_lua_channel_handle_t
+{
+    ecs_lua_channel_t *channel;
+    ecs_entity_t type;
+    void *scratch; /* Encoded value, the queue is not touched if encoding fails */
+}ecs_lua_channel_handle_t;
+
+static ecs_lua_channel_t *channels;
+static ecs_os_mutex_t channels_lock; /* NULL without threading support */
+
+void ecs_lua_channel_init(void)
+{
+    if(!channels_lock && ecs_os_has_threading()) channels_lock = ecs_os_mutex_new();
+}
+
+static void registry_lock(void)
+{
+    if(channels_lock) ecs_os_mutex_lock(channels_lock);
+}
+
+static void registry_unlock(void)
+{
+    if(channels_lock) ecs_os_mutex_unlock(channels_lock);
+}
+
+/* Returns the member layout of a type as a string, type entities
+   differ between worlds so members are compared by kind.
+   Returns NULL for types with strings or vectors, values are copied as raw bytes */
+static char *type_layout(const ecs_world_t *world, ecs_entity_t type)
+{
+    const EcsMetaTypeSerialized *ser = ecs_get(world, type, EcsMetaTypeSerialized);
+    ecs_assert(ser != NULL, ECS_INTERNAL_ERROR, NULL);
+
+    ecs_meta_type_op_t *ops = ecs_vec_first(&ser->ops);
+    int32_t i, count = ecs_vec_count(&ser->ops);
+
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+
+    for(i=0; i < count; i++)
+    {
+        ecs_meta_type_op_t *op = &ops[i];
+
+        if(op->kind == EcsOpString || op->kind == EcsOpVector)
+        {
+            ecs_strbuf_reset(&buf);
+            return NULL;
+        }
+
+        ecs_strbuf_append(&buf, "%s:%d:%d:%d:%d;", op->name ? op->name : "",
+            op->kind, op->offset, op->count, op->size);
+    }
+
+    return ecs_strbuf_get(&buf);
+}
+
+static ecs_lua_channel_handle_t *checkchannel(lua_State *L, int arg)
+{
+    ecs_lua_channel_handle_t *h = luaL_checkudata(L, arg, "ecs_channel_t");
+
+    if(!h->channel) luaL_argerror(L, arg, "channel is closed");
+
+    return h;
+}
+
+/* Returns the channel with the given name, a new one is created if it does not exist */
+static ecs_lua_channel_t *channel_open(const char *name, const char *type_path, const char *layout, ecs_size_t size, int32_t capacity)
+{
+    registry_lock();
+
+    ecs_lua_channel_t *ch = channels;
+
+    for(; ch; ch = ch->next) if(!strcmp(ch->name, name)) break;
+
+    if(ch)
+    {
+        if(strcmp(ch->type_path, type_path) || strcmp(ch->layout, layout) || ch->size != size) ch = NULL;
+        else ch->refs++;
+
+        registry_unlock();
+
+        return ch;
+    }
+
+    int32_t cells = 1;
+    while(cells < capacity) cells <<= 1;
+
+    ch = ecs_os_calloc(sizeof(ecs_lua_channel_t));
+
+    ch->refs = 1;
+    ch->name = ecs_os_strdup(name);
+    ch->type_path = ecs_os_strdup(type_path);
+    ch->layout = ecs_os_strdup(layout);
+    ch->size = size;
+    ch->mask = cells - 1;
+    ch->ready = ecs_os_calloc(cells * ECS_SIZEOF(int32_t));
+    ch->data = ecs_os_malloc(cells * size);
+
+    ch->next = channels;
+    channels = ch;
+
+    registry_unlock();
+
+    return ch;
+}
+
+static void channel_release(ecs_lua_channel_t *ch)
+{
+    registry_lock();
+
+    if(--ch->refs)
+    {
+        registry_unlock();
+        return;
+    }
+
+    ecs_lua_channel_t **ptr = &channels;
+
+    while(*ptr != ch) ptr = &(*ptr)->next;
+
+    *ptr = ch->next;
+
+    registry_unlock();
+
+    ecs_os_free(ch->name);
+    ecs_os_free(ch->type_path);
+    ecs_os_free(ch->layout);
+    ecs_os_free(ch->ready);
+    ecs_os_free(ch->data);
+    ecs_os_free(ch);
+}
+
+static bool channel_push(ecs_lua_channel_t *ch, const void *value)
+{
+    if(ecs_os_ainc(&ch->count) > ch->mask + 1)
+    {
+        ecs_os_adec(&ch->count);
+        return false;
+    }
+
+    int32_t cell = (ecs_os_ainc(&ch->head) - 1) & ch->mask;
+
+    ecs_os_memcpy(ECS_ELEM(ch->data, ch->size, cell), value, ch->size);
+
+    /* Publish */
+    ecs_os_ainc(&ch->ready[cell]);
+
+    return true;
+}
+
+/* Copies the oldest published value to value */
+static bool channel_pop(ecs_lua_channel_t *ch, void *value)
+{
+    int32_t cell = ch->tail & ch->mask;
+
+    /* The flag is taken with an atomic (fenced) operation so the value is
+       read after it, a producer may publish the cell in between */
+    if(ecs_os_adec(&ch->ready[cell]) < 0)
+    {
+        ecs_os_ainc(&ch->ready[cell]);
+        return false;
+    }
+
+    /* Producers don't reuse the cell until count is decremented */
+    ecs_os_memcpy(value, ECS_ELEM(ch->data, ch->size, cell), ch->size);
+
+    ch->tail++;
+    ecs_os_adec(&ch->count);
+
+    return true;
+}
+
+/* Drains are claimed by Lua states, any coroutine of the state may drain */
+static lua_State *main_thread(lua_State *L)
+{
+    lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+    lua_State *main = lua_tothread(L, -1);
+    lua_pop(L, 1);
+
+    return main;
+}
+
+int channel_gc(lua_State *L)
+{
+    ecs_lua_channel_handle_t *h = luaL_checkudata(L, 1, "ecs_channel_t");
+
+    if(!h->channel) return 0;
+
+    lua_State *main = main_thread(L);
+
+    registry_lock();
+    if(h->channel->consumer == main) h->channel->consumer = NULL;
+    registry_unlock();
+
+    channel_release(h->channel);
+    ecs_os_free(h->scratch);
+
+    h->channel = NULL;
+
+    return 0;
+}
+
+int channel__index(lua_State *L)
+{
+    checkchannel(L, 1);
+
+    lua_pushvalue(L, 2);
+    lua_rawget(L, lua_upvalueindex(1));
+
+    return 1;
+}
+
+int channel__len(lua_State *L)
+{
+    ecs_lua_channel_handle_t *h = checkchannel(L, 1);
+
+    lua_pushinteger(L, h->channel->count);
+
+    return 1;
+}
+
+int channel_send(lua_State *L)
+{
+    ecs_lua_channel_handle_t *h = checkchannel(L, 1);
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+
+    luaL_checkany(L, 2);
+
+    ecs_os_memset(h->scratch, 0, h->channel->size);
+    ecs_lua_to_ptr(w, L, 2, h->type, h->scratch);
+
+    lua_pushboolean(L, channel_push(h->channel, h->scratch));
+
+    return 1;
+}
+
+int channel_drain(lua_State *L)
+{
+    ecs_lua_channel_handle_t *h = checkchannel(L, 1);
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+    ecs_lua_channel_t *ch = h->channel;
+
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+    lua_Integer max = luaL_optinteger(L, 3, LUA_MAXINTEGER);
+
+    lua_State *main = main_thread(L);
+
+    registry_lock();
+
+    if(!ch->consumer) ch->consumer = main;
+    bool consumer = ch->consumer == main;
+
+    registry_unlock();
+
+    if(!consumer) return luaL_error(L, "channel is drained by another Lua state");
+
+    lua_Integer n = 0;
+
+    /* One table is reused for all values */
+    lua_settop(L, 2);
+    lua_newtable(L);
+
+    for(; n < max && channel_pop(ch, h->scratch); n++)
+    {
+        ecs_lua_type_update(w, L, 3, h->type, h->scratch);
+
+        lua_pushvalue(L, 2);
+        lua_pushvalue(L, 3);
+        lua_call(L, 1, 0);
+    }
+
+    lua_pushinteger(L, n);
+
+    return 1;
+}
+
+int new_channel(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    const char *name = luaL_checkstring(L, 1);
+    ecs_entity_t type = luaL_checkinteger(L, 2);
+    lua_Integer capacity = luaL_optinteger(L, 3, 1024);
+
+    if(capacity < 1 || capacity > (1 << 24)) return luaL_argerror(L, 3, "capacity out of range");
+
+    if(!ecs_get(w, type, EcsMetaTypeSerialized)) return luaL_argerror(L, 2, "type has no reflection data");
+    if(!ecs_has(w, type, EcsStruct)) return luaL_argerror(L, 2, "type is not a struct");
+
+    /* Values are copied between worlds as raw bytes */
+    const ecs_type_info_t *ti = ecs_get_type_info(w, type);
+
+    if(!ti || !ti->size) return luaL_argerror(L, 2, "invalid type");
+    if(ti->hooks.dtor || ti->hooks.copy || ti->hooks.move) return luaL_argerror(L, 2, "type is not trivially copyable");
+
+    /* Reflected strings and vectors have no hooks */
+    char *layout = type_layout(w, type);
+
+    if(!layout) return luaL_argerror(L, 2, "type is not trivially copyable");
+
+    ecs_lua_channel_handle_t *h = lua_newuserdata(L, sizeof(ecs_lua_channel_handle_t));
+
+    h->channel = NULL;
+    h->type = type;
+    h->scratch = NULL;
+
+    /* Associate world with the object for type conversions */
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_setuservalue(L, -2);
+
+    luaL_setmetatable(L, "ecs_channel_t");
+
+    char *path = ecs_get_fullpath(w, type);
+    ecs_lua_channel_t *ch = channel_open(name, path, layout, ti->size, (int32_t)capacity);
+    ecs_os_free(layout);
+    ecs_os_free(path);
+
+    if(!ch) return luaL_argerror(L, 2, "type does not match the channel type");
+
+    h->channel = ch;
+    h->scratch = ecs_os_malloc(ti->size);
+
+    return 1;
+}
@@ -65,8 +65,13 @@ bool ecs_lua_progress(lua_State *L, lua_Number delta_time)
 
     lua_pushnumber(L, delta_time);
 
+    ecs_time_t span_start;
+    bool trace = ecs_lua_trace_begin(L, &span_start);
+
     int ret = lua_pcall(L, 1, 1, 0);
 
+    if(trace) ecs_lua_trace_end(L, &span_start, "lua", "progress");
+
     if(ret)
     {
         const char *err = lua_tostring(L, lua_gettop(L));
@@ -214,6 +219,7 @@ int entity_override(lua_State *L);
 int new_enum(lua_State *L);
 int new_bitmask(lua_State *L);
 int new_array(lua_State *L);
+int new_vector(lua_State *L);
 int new_struct(lua_State *L);
 int new_alias(lua_State *L);
 
@@ -233,6 +239,8 @@ int new_prefab(lua_State *L);
 
 /* Hierarchy */
 int get_child_count(lua_State *L);
+int children(lua_State *L);
+int descendants(lua_State *L);
 int set_scope(lua_State *L);
 int get_scope(lua_State *L);
 int set_name_prefix(lua_State *L);
@@ -245,11 +253,17 @@ int iter_term(lua_State *L);
 int iter_terms(lua_State *L);
 int is_owned(lua_State *L);
 int term_id(lua_State *L);
+int filter_new(lua_State *L);
+int filter_gc(lua_State *L);
 int filter_iter(lua_State *L);
 int filter_next(lua_State *L);
 int term_iter(lua_State *L);
 int term_next(lua_State *L);
 int iter_next(lua_State *L);
+int page_iter(lua_State *L);
+int page_next(lua_State *L);
+int worker_iter(lua_State *L);
+int worker_next(lua_State *L);
 
 /* Query */
 int query_gc(lua_State *L);
@@ -259,6 +273,8 @@ int query_iter(lua_State *L);
 int query_next(lua_State *L);
 int query_changed(lua_State *L);
 int each_func(lua_State *L);
+int each__close(lua_State *L);
+int each__gc(lua_State *L);
 
 /* Snapshot */
 int snapshot_take(lua_State *L);
@@ -267,10 +283,24 @@ int snapshot_iter(lua_State *L);
 int snapshot_next(lua_State *L);
 int snapshot_gc(lua_State *L);
 
+/* Vector view */
+int vector__index(lua_State *L);
+int vector__newindex(lua_State *L);
+int vector__len(lua_State *L);
+int vector_get(lua_State *L);
+int vector_push(lua_State *L);
+int vector_pop(lua_State *L);
+int vector_resize(lua_State *L);
+int vector_view(lua_State *L);
+int vector_elem__index(lua_State *L);
+int vector_elem__newindex(lua_State *L);
+
 /* System */
 int new_system(lua_State *L);
+int new_system_group(lua_State *L);
 int new_trigger(lua_State *L);
 int new_observer(lua_State *L);
+int emit_event(lua_State *L);
 int run_system(lua_State *L);
 int set_system_context(lua_State *L);
 
@@ -284,6 +314,9 @@ int print_err(lua_State *L);
 int print_dbg(lua_State *L);
 int print_warn(lua_State *L);
 int log_set_level(lua_State *L);
+int log_open(lua_State *L);
+int log_close(lua_State *L);
+int logger_gc(lua_State *L);
 int log_enable_colors(lua_State *L);
 
 /* Misc */
@@ -309,6 +342,23 @@ int start_timer(lua_State *L);
 int stop_timer(lua_State *L);
 int set_rate_filter(lua_State *L);
 int set_tick_source(lua_State *L);
+int wheel_gc(lua_State *L);
+int timer_after(lua_State *L);
+int timer_every(lua_State *L);
+int timer_cancel(lua_State *L);
+
+/* Shard */
+int shard_start(lua_State *L);
+int shard_stop(lua_State *L);
+int shard_stats(lua_State *L);
+
+/* Channel */
+int new_channel(lua_State *L);
+int channel_gc(lua_State *L);
+int channel__index(lua_State *L);
+int channel__len(lua_State *L);
+int channel_send(lua_State *L);
+int channel_drain(lua_State *L);
 
 /* Pipeline */
 int new_pipeline(lua_State *L);
@@ -332,6 +382,19 @@ int world_fini(lua_State *L);
 int world_gc(lua_State *L);
 int world_info(lua_State *L);
 int world_stats(lua_State *L);
+int stats_view__index(lua_State *L);
+int stats_view_update(lua_State *L);
+int world_stats_view(lua_State *L);
+int export_stats(lua_State *L);
+
+/* Profiler */
+int profiler_gc(lua_State *L);
+int profiler_start(lua_State *L);
+int profiler_stop(lua_State *L);
+
+/* Trace */
+int trace_start(lua_State *L);
+int trace_stop(lua_State *L);
 int dim(lua_State *L);
 
 /* EmmyLua */
@@ -397,6 +460,7 @@ static const luaL_Reg ecs_lib[] =
     { "enum", new_enum },
     { "bitmask", new_bitmask },
     { "array", new_array },
+    { "vector", new_vector },
     { "struct", new_struct },
     { "alias", new_alias },
 
@@ -414,6 +478,8 @@ static const luaL_Reg ecs_lib[] =
     { "prefab", new_prefab },
 
     { "get_child_count" , get_child_count },
+    { "children", children },
+    { "descendants", descendants },
     { "set_scope", set_scope },
     { "get_scope", get_scope },
     { "set_name_prefix", set_name_prefix },
@@ -427,11 +493,16 @@ static const luaL_Reg ecs_lib[] =
     { "is_owned", is_owned },
     { "column_entity", term_id }, // compat
     { "term_id", term_id },
+    { "filter", filter_new },
     { "filter_iter", filter_iter },
     { "filter_next", filter_next },
     { "term_iter", term_iter },
     { "term_next", term_next },
     { "iter_next", iter_next },
+    { "page", page_iter },
+    { "page_next", page_next },
+    { "worker", worker_iter },
+    { "worker_next", worker_next },
 
     { "query", query_new },
     { "subquery", subquery_new },
@@ -441,8 +512,11 @@ static const luaL_Reg ecs_lib[] =
     { "each", each_func },
 
     { "system", new_system },
+    { "system_group", new_system_group },
     { "trigger", new_trigger },
     { "observer", new_observer },
+    { "emit", emit_event },
+    { "vector_view", vector_view },
     { "run", run_system },
     { "set_system_context", set_system_context },
 
@@ -459,6 +533,8 @@ static const luaL_Reg ecs_lib[] =
     { "dbg", print_dbg },
     { "warn", print_warn },
     { "log_set_level", log_set_level },
+    { "log_open", log_open },
+    { "log_close", log_close },
     { "tracing_enable", log_set_level }, //compat
     { "log_enable_colors", log_enable_colors },
     { "tracing_color_enable", log_enable_colors }, //compat
@@ -482,6 +558,14 @@ static const luaL_Reg ecs_lib[] =
     { "stop_timer", stop_timer },
     { "set_rate_filter", set_rate_filter },
     { "set_tick_source", set_tick_source },
+    { "after", timer_after },
+    { "every", timer_every },
+    { "cancel", timer_cancel },
+
+    { "shard_start", shard_start },
+    { "shard_stop", shard_stop },
+    { "shard_stats", shard_stats },
+    { "channel", new_channel },
 
     { "pipeline", new_pipeline },
     { "set_pipeline", set_pipeline },
@@ -505,6 +589,13 @@ static const luaL_Reg ecs_lib[] =
     { "fini", world_fini },
     { "world_info", world_info },
     { "world_stats", world_stats },
+    { "world_stats_view", world_stats_view },
+    { "export_stats", export_stats },
+
+    { "profiler_start", profiler_start },
+    { "profiler_stop", profiler_stop },
+    { "trace_start", trace_start },
+    { "trace_stop", trace_stop },
     { "dim", dim },
 
     { "emmy_class", emmy_class },
@@ -534,7 +625,18 @@ static void register_types(lua_State *L)
     lua_setfield(L, -2, "__mode");
     lua_pop(L, 1);
 
+    luaL_newmetatable(L, "ecs_filter_cache_t");
+    lua_pushstring(L, "k");
+    lua_setfield(L, -2, "__mode");
+    lua_pop(L, 1);
+
     luaL_newmetatable(L, "ecs_readonly");
+    lua_pushcfunction(L, ecs_lua__readonly_index);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, ecs_lua__readonly_len);
+    lua_setfield(L, -2, "__len");
+    lua_pushcfunction(L, ecs_lua__readonly_pairs);
+    lua_setfield(L, -2, "__pairs");
     lua_pushcfunction(L, ecs_lua__readonly);
     lua_setfield(L, -2, "__newindex");
     lua_pushcfunction(L, ecs_lua__readonly);
@@ -548,11 +650,85 @@ static void register_types(lua_State *L)
     lua_setfield(L, -2, "__gc");
     lua_pop(L, 1);
 
+    luaL_newmetatable(L, "ecs_each_t");
+    lua_pushcfunction(L, each__close);
+    lua_setfield(L, -2, "__close");
+    lua_pushcfunction(L, each__gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, "ecs_logger_t");
+    lua_pushcfunction(L, logger_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, "ecs_filter_t");
+    lua_pushcfunction(L, filter_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
     luaL_newmetatable(L, "ecs_snapshot_t");
     lua_pushcfunction(L, snapshot_gc);
     lua_setfield(L, -2, "__gc");
     lua_pop(L, 1);
 
+    luaL_newmetatable(L, "ecs_vector_view_t");
+    lua_pushcfunction(L, vector__newindex);
+    lua_setfield(L, -2, "__newindex");
+    lua_pushcfunction(L, vector__len);
+    lua_setfield(L, -2, "__len");
+    lua_createtable(L, 0, 4);
+    lua_pushcfunction(L, vector_get);
+    lua_setfield(L, -2, "get");
+    lua_pushcfunction(L, vector_push);
+    lua_setfield(L, -2, "push");
+    lua_pushcfunction(L, vector_pop);
+    lua_setfield(L, -2, "pop");
+    lua_pushcfunction(L, vector_resize);
+    lua_setfield(L, -2, "resize");
+    lua_pushcclosure(L, vector__index, 1);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, "ecs_vector_elem_t");
+    lua_pushcfunction(L, vector_elem__index);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, vector_elem__newindex);
+    lua_setfield(L, -2, "__newindex");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, "ecs_world_stats_view_t");
+    lua_createtable(L, 0, 1);
+    lua_pushcfunction(L, stats_view_update);
+    lua_setfield(L, -2, "update");
+    lua_pushcclosure(L, stats_view__index, 1);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, "ecs_profiler_t");
+    lua_pushcfunction(L, profiler_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, "ecs_timer_wheel_t");
+    lua_pushcfunction(L, wheel_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, "ecs_channel_t");
+    lua_pushcfunction(L, channel_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pushcfunction(L, channel__len);
+    lua_setfield(L, -2, "__len");
+    lua_createtable(L, 0, 2);
+    lua_pushcfunction(L, channel_send);
+    lua_setfield(L, -2, "send");
+    lua_pushcfunction(L, channel_drain);
+    lua_setfield(L, -2, "drain");
+    lua_pushcclosure(L, channel__index, 1);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
     luaL_newmetatable(L, "ecs_time_t");
     lua_pushcfunction(L, time__tostring);
     lua_setfield(L, -2, "__tostring");
@@ -629,6 +805,17 @@ int luaopen_ecs(lua_State *L)
         lua_pushvalue(L, -2); /* world userdata */
         lua_rawseti(L, -2, ECS_LUA_APIWORLD);
 
+        /* world[filters] = { [expr|desc] = filter, [filter] = true, [0] = expr count } */
+        lua_createtable(L, 0, 16);
+        luaL_setmetatable(L, "ecs_filter_cache_t");
+        lua_rawseti(L, -2, ECS_LUA_FILTERS);
+
+        lua_createtable(L, 4, 0);
+        lua_rawseti(L, -2, ECS_LUA_LOOKUP);
+
+        lua_createtable(L, 16, 0);
+        lua_rawseti(L, -2, ECS_LUA_SYSTEMS);
+
     lua_pop(L, 1); /* registry[world] */
 
     luaL_setfuncs(L, ecs_lib, 1);
@@ -778,12 +965,22 @@ void EcsLuaHost__OnRemove(ecs_iter_t *it)
     }
 }
 
+static void lookup_invalidate(ecs_iter_t *it)
+{
+    ecs_lua_lookup_invalidate(it->real_world);
+}
+
 void FlecsLuaImport(ecs_world_t *w)
 {
     ECS_MODULE(w, FlecsLua);
 
     ECS_IMPORT(w, FlecsMeta);
 
+    /* Process-wide locks, the first import must happen before
+       other threads use FlecsLua */
+    ecs_lua_shard_init();
+    ecs_lua_channel_init();
+
     ecs_set_name_prefix(w, "EcsLua");
 
     ECS_COMPONENT_DEFINE(w, EcsLuaHost);
@@ -862,6 +1059,29 @@ void FlecsLuaImport(ecs_world_t *w)
     ecs_assert(sizeof(EcsLuaCounter) == sizeof(ecs_metric_t), ECS_INTERNAL_ERROR, NULL);
     ecs_assert(sizeof(EcsLuaWorldStats) == sizeof(ecs_world_stats_t), ECS_INTERNAL_ERROR, NULL);
 
+    /* Invalidate lookup caches */
+    ecs_observer_init(w, &(ecs_observer_desc_t)
+    {
+        .filter.terms = {{ ecs_pair(ecs_id(EcsIdentifier), EcsWildcard) }},
+        .filter.flags = EcsFilterMatchPrefab | EcsFilterMatchDisabled,
+        .events = { EcsOnSet, EcsOnRemove },
+        .callback = lookup_invalidate
+    });
+
+    /* Unnamed children cannot be looked up, only named entities are matched */
+    ecs_observer_init(w, &(ecs_observer_desc_t)
+    {
+        .filter.terms = {
+            { ecs_pair(EcsChildOf, EcsWildcard) },
+            { ecs_pair(ecs_id(EcsIdentifier), EcsName) }
+        },
+        .filter.flags = EcsFilterMatchPrefab | EcsFilterMatchDisabled,
+        .events = { EcsOnAdd, EcsOnRemove },
+        .callback = lookup_invalidate
+    });
+
+    ecs_lua_timer_init(w);
+
     ecs_set_hooks(w, EcsLuaHost,
     {
         .ctor = ecs_default_ctor,
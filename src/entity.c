@@ -222,14 +222,133 @@ int entity_fullpath(lua_State *L)
     return 1;
 }
 
+enum
+{
+    LOOKUP_NAME = 1,
+    LOOKUP_FULLPATH,
+    LOOKUP_SYMBOL,
+    LOOKUP_PATH
+};
+
+/* Bumped when names, symbols, aliases or the hierarchy of named entities change */
+void ecs_lua_lookup_invalidate(const ecs_world_t *world)
+{
+    world = ecs_get_world(world);
+
+    if(ecs_is_fini(world)) return;
+
+    const EcsLuaHost *host = ecs_singleton_get(world, EcsLuaHost);
+
+    if(host && host->ctx) host->ctx->lookup_generation++;
+}
+
+static int32_t lookup_generation(const ecs_world_t *world)
+{
+    const EcsLuaHost *host = ecs_singleton_get(world, EcsLuaHost);
+
+    return host && host->ctx ? host->ctx->lookup_generation : 0;
+}
+
+/* Pushes the lookup cache table for kind, results are cached
+   in the root scope only since lookups are relative to the scope */
+static bool push_lookup_cache(lua_State *L, ecs_world_t *w, int kind)
+{
+    if(ecs_get_scope(w)) return false;
+
+    const ecs_world_t *world = ecs_get_world(w);
+    int32_t current = lookup_generation(world);
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, world);
+    lua_rawgeti(L, -1, ECS_LUA_LOOKUP);
+
+    lua_rawgeti(L, -1, 0);
+    int32_t generation = (int32_t)lua_tointeger(L, -1);
+    lua_pop(L, 1);
+
+    if(generation != current)
+    {/* registry[world][lookup] = { [0] = generation } */
+        lua_pop(L, 1);
+        lua_createtable(L, 4, 0);
+        lua_pushinteger(L, current);
+        lua_rawseti(L, -2, 0);
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, -3, ECS_LUA_LOOKUP);
+    }
+
+    if(lua_rawgeti(L, -1, kind) == LUA_TNIL)
+    {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, -3, kind);
+    }
+
+    lua_replace(L, -3);
+    lua_pop(L, 1);
+
+    return true;
+}
+
+/* Pushes the cached entity for the key at arg, leaves the cache below it */
+static bool lookup_cached(lua_State *L, int arg)
+{
+    lua_pushvalue(L, arg);
+
+    if(lua_rawget(L, -2) == LUA_TNUMBER) return true;
+
+    lua_pop(L, 1);
+
+    return false;
+}
+
+/* Number of entries, keys are strings or numbers */
+static const char lookup_count_key = 'c';
+
+/* cache[key] = e, expects the cache on top of the stack.
+   The cache is cleared when it is full so generated names don't grow it */
+static void lookup_store(lua_State *L, int arg, ecs_entity_t e)
+{
+    lua_rawgetp(L, -1, &lookup_count_key);
+    lua_Integer count = lua_tointeger(L, -1);
+    lua_pop(L, 1);
+
+    if(count >= ECS_LUA_LOOKUP_CACHE_MAX)
+    {
+        lua_pushnil(L);
+
+        while(lua_next(L, -2))
+        {
+            lua_pop(L, 1);
+            lua_pushvalue(L, -1);
+            lua_pushnil(L);
+            lua_rawset(L, -4);
+        }
+
+        count = 0;
+    }
+
+    lua_pushinteger(L, count + 1);
+    lua_rawsetp(L, -2, &lookup_count_key);
+
+    lua_pushvalue(L, arg);
+    lua_pushinteger(L, e);
+    lua_rawset(L, -3);
+}
+
 int lookup_entity(lua_State *L)
 {
     ecs_world_t *w = ecs_lua_world(L);
 
     const char *name = luaL_checkstring(L, 1);
 
+    bool cache = push_lookup_cache(L, w, LOOKUP_NAME);
+
+    if(cache && lookup_cached(L, 1)) return 1;
+
     ecs_entity_t e = ecs_lookup(w, name);
 
+    if(cache) lookup_store(L, 1, e);
+
     lua_pushinteger(L, e);
 
     return 1;
@@ -258,8 +377,26 @@ int lookup_path(lua_State *L)
     const char *sep = luaL_optstring(L, 3, ".");
     const char *prefix = luaL_optstring(L, 4, NULL);
 
+    /* Only lookups with the default separator and prefix are cached */
+    bool cache = !strcmp(sep, ".") && !prefix && push_lookup_cache(L, w, LOOKUP_PATH);
+
+    if(cache)
+    {/* cache[parent][path] */
+        if(lua_rawgeti(L, -1, parent) == LUA_TNIL)
+        {
+            lua_pop(L, 1);
+            lua_newtable(L);
+            lua_pushvalue(L, -1);
+            lua_rawseti(L, -3, parent);
+        }
+
+        if(lookup_cached(L, 2)) return 1;
+    }
+
     ecs_entity_t e = ecs_lookup_path_w_sep(w, parent, path, sep, prefix, false);
 
+    if(cache) lookup_store(L, 2, e);
+
     lua_pushinteger(L, e);
 
     return 1;
@@ -271,8 +408,14 @@ int lookup_fullpath(lua_State *L)
 
     const char *name = luaL_checkstring(L, 1);
 
+    bool cache = push_lookup_cache(L, w, LOOKUP_FULLPATH);
+
+    if(cache && lookup_cached(L, 1)) return 1;
+
     ecs_entity_t e = ecs_lookup_fullpath(w, name);
 
+    if(cache) lookup_store(L, 1, e);
+
     lua_pushinteger(L, e);
 
     return 1;
@@ -284,8 +427,14 @@ int lookup_symbol(lua_State *L)
 
     const char *name = luaL_checkstring(L, 1);
 
+    bool cache = push_lookup_cache(L, w, LOOKUP_SYMBOL);
+
+    if(cache && lookup_cached(L, 1)) return 1;
+
     ecs_entity_t e = ecs_lookup_symbol(w, name, true);
 
+    if(cache) lookup_store(L, 1, e);
+
     lua_pushinteger(L, e);
 
     return 1;
@@ -300,6 +449,8 @@ int use_alias(lua_State *L)
 
     ecs_set_alias(w, e, name);
 
+    ecs_lua_lookup_invalidate(w);
+
     return 0;
 }
 
@@ -958,6 +1109,28 @@ int new_array(lua_State *L)
     return 1;
 }
 
+int new_vector(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    const char *name = luaL_checkstring(L, 1);
+    lua_Integer element = luaL_checkinteger(L, 2);
+
+    if(ecs_lookup_fullpath(w, name) || ecs_lookup(w, name)) luaL_argerror(L, 1, "component already exists");
+
+    ecs_vector_desc_t desc = { .type = element };
+
+    ecs_entity_t component = ecs_vector_init(w, &desc);
+
+    ecs_set_name(w, component, name);
+
+    init_scope(w, component);
+
+    lua_pushinteger(L, component);
+
+    return 1;
+}
+
 int new_struct(lua_State *L)
 {
     ecs_world_t *w = ecs_lua_world(L);
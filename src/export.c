@@ -0,0 +1,392 @@
+#include "private.h"
+
+#include <stdio.h>
+
+typedef struct ecs_lua_export_metric_t
+{
+    char *name;
+    int32_t offset;
+    bool counter;
+}ecs_lua_export_metric_t;
+
+typedef struct ecs_lua_export_system_t
+{
+    char *name;
+    double time_total;
+    int64_t calls;
+}ecs_lua_export_system_t;
+
+/* Latest values, formatted by the writer */
+typedef struct ecs_lua_export_sample_t
+{
+    double *values;
+    ecs_world_info_t info;
+    ecs_vec_t systems; /* ecs_lua_export_system_t */
+}ecs_lua_export_sample_t;
+
+typedef struct ecs_lua_export_t
+{
+    char *path;
+
+    ecs_world_stats_t stats;
+
+    ecs_lua_export_metric_t *metrics;
+    int32_t metric_count;
+
+    /* next is filled by the system, work is owned by the writer thread,
+       ready is swapped with either one under the lock */
+    ecs_lua_export_sample_t samples[3];
+    ecs_lua_export_sample_t *next, *ready, *work;
+
+    ecs_os_thread_t thread;
+    ecs_os_mutex_t lock;
+    ecs_os_cond_t cond;
+    bool threaded, pending, quit;
+}ecs_lua_export_t;
+
+static void sample_clear(ecs_lua_export_sample_t *sample)
+{
+    ecs_lua_export_system_t *systems = ecs_vec_first_t(&sample->systems, ecs_lua_export_system_t);
+    int32_t i, count = ecs_vec_count(&sample->systems);
+
+    for(i=0; i < count; i++) ecs_os_free(systems[i].name);
+
+    ecs_vec_clear(&sample->systems);
+}
+
+static void append_label(ecs_strbuf_t *buf, const char *value)
+{
+    for(; *value; value++)
+    {
+        if(*value == '\\') ecs_strbuf_appendstr(buf, "\\\\");
+        else if(*value == '"') ecs_strbuf_appendstr(buf, "\\\"");
+        else if(*value == '\n') ecs_strbuf_appendstr(buf, "\\n");
+        else ecs_strbuf_appendch(buf, *value);
+    }
+}
+
+static void append_metric(ecs_strbuf_t *buf, const char *name, const char *type, double value)
+{
+    ecs_strbuf_append(buf, "# TYPE flecs_%s %s\n", name, type);
+
+    if(!strcmp(type, "counter")) ecs_strbuf_append(buf, "flecs_%s_total %g\n", name, value);
+    else ecs_strbuf_append(buf, "flecs_%s %g\n", name, value);
+}
+
+static char *format_sample(const ecs_lua_export_t *exp, const ecs_lua_export_sample_t *sample)
+{
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    int32_t i;
+
+    for(i=0; i < exp->metric_count; i++)
+    {
+        const ecs_lua_export_metric_t *m = &exp->metrics[i];
+        append_metric(&buf, m->name, m->counter ? "counter" : "gauge", sample->values[i]);
+    }
+
+    const ecs_world_info_t *wi = &sample->info;
+
+    append_metric(&buf, "info_delta_time_seconds", "gauge", wi->delta_time);
+    append_metric(&buf, "info_target_fps", "gauge", wi->target_fps);
+    append_metric(&buf, "info_frame_time_seconds", "counter", wi->frame_time_total);
+    append_metric(&buf, "info_system_time_seconds", "counter", wi->system_time_total);
+    append_metric(&buf, "info_merge_time_seconds", "counter", wi->merge_time_total);
+    append_metric(&buf, "info_world_time_seconds", "counter", wi->world_time_total);
+    append_metric(&buf, "info_frames", "counter", wi->frame_count_total);
+    append_metric(&buf, "info_merges", "counter", wi->merge_count_total);
+    append_metric(&buf, "info_pipeline_builds", "counter", wi->pipeline_build_count_total);
+    append_metric(&buf, "info_systems_ran_frame", "gauge", wi->systems_ran_frame);
+
+    const ecs_lua_export_system_t *systems = ecs_vec_first_t(&sample->systems, ecs_lua_export_system_t);
+    int32_t count = ecs_vec_count(&sample->systems);
+
+    ecs_strbuf_appendstr(&buf, "# TYPE flecs_lua_system_time_seconds counter\n");
+
+    for(i=0; i < count; i++)
+    {
+        ecs_strbuf_appendstr(&buf, "flecs_lua_system_time_seconds_total{system=\"");
+        append_label(&buf, systems[i].name);
+        ecs_strbuf_append(&buf, "\"} %g\n", systems[i].time_total);
+    }
+
+    ecs_strbuf_appendstr(&buf, "# TYPE flecs_lua_system_calls counter\n");
+
+    for(i=0; i < count; i++)
+    {
+        ecs_strbuf_appendstr(&buf, "flecs_lua_system_calls_total{system=\"");
+        append_label(&buf, systems[i].name);
+        ecs_strbuf_append(&buf, "\"} %lld\n", (long long)systems[i].calls);
+    }
+
+    ecs_strbuf_appendstr(&buf, "# EOF\n");
+
+    return ecs_strbuf_get(&buf);
+}
+
+/* The file is replaced atomically */
+static void write_sample(const ecs_lua_export_t *exp, const ecs_lua_export_sample_t *sample)
+{
+    char *text = format_sample(exp, sample);
+    char *tmp = ecs_asprintf("%s.tmp", exp->path);
+    FILE *f = fopen(tmp, "wb");
+    int err = 1;
+
+    if(f)
+    {
+        size_t len = strlen(text);
+        err = fwrite(text, 1, len, f) != len;
+        err |= fclose(f);
+
+        if(!err && rename(tmp, exp->path))
+        {/* rename() does not replace existing files everywhere */
+            remove(exp->path);
+            err = rename(tmp, exp->path);
+        }
+
+        if(err) remove(tmp);
+    }
+
+    if(err) ecs_os_err("failed to write stats to %s", exp->path);
+
+    ecs_os_free(tmp);
+    ecs_os_free(text);
+}
+
+static void *writer_thread(void *arg)
+{
+    ecs_lua_export_t *exp = arg;
+
+    ecs_os_mutex_lock(exp->lock);
+
+    for(;;)
+    {
+        while(!exp->pending && !exp->quit) ecs_os_cond_wait(exp->cond, exp->lock);
+
+        /* The last sample is still written when stopping */
+        if(!exp->pending) break;
+
+        ecs_lua_export_sample_t *tmp = exp->work;
+        exp->work = exp->ready;
+        exp->ready = tmp;
+        exp->pending = false;
+
+        ecs_os_mutex_unlock(exp->lock);
+
+        write_sample(exp, exp->work);
+
+        ecs_os_mutex_lock(exp->lock);
+    }
+
+    ecs_os_mutex_unlock(exp->lock);
+
+    return NULL;
+}
+
+static void collect_systems(ecs_world_t *w, ecs_lua_export_sample_t *sample)
+{
+    const EcsLuaHost *host = ecs_singleton_get(w, EcsLuaHost);
+
+    if(!host) return;
+
+    lua_State *L = host->L;
+
+    ecs_lua__prolog(L);
+
+    if(lua_rawgetp(L, LUA_REGISTRYINDEX, ecs_get_world(w)) == LUA_TTABLE &&
+       lua_rawgeti(L, -1, ECS_LUA_SYSTEMS) == LUA_TTABLE)
+    {
+        int i, len = lua_rawlen(L, -1);
+
+        for(i=1; i <= len; i++)
+        {
+            lua_rawgeti(L, -1, i);
+            const ecs_lua_callback *cb = lua_touserdata(L, -1);
+            lua_pop(L, 1);
+
+            if(!cb || !cb->entity || !ecs_is_alive(w, cb->entity)) continue;
+
+            ecs_lua_export_system_t *s = ecs_vec_append_t(NULL, &sample->systems, ecs_lua_export_system_t);
+
+            s->name = ecs_get_fullpath(w, cb->entity);
+            s->time_total = cb->time_total;
+            s->calls = cb->calls;
+        }
+
+        lua_pop(L, 1);
+    }
+
+    lua_pop(L, 1);
+
+    ecs_lua__epilog(L);
+}
+
+static void ExportStats(ecs_iter_t *it)
+{
+    ecs_lua_export_t *exp = it->ctx;
+    ecs_world_t *w = it->world;
+    ecs_lua_export_sample_t *sample = exp->next;
+
+    ecs_world_stats_get(w, &exp->stats);
+
+    int32_t i, t = exp->stats.t;
+
+    for(i=0; i < exp->metric_count; i++)
+    {
+        const ecs_lua_export_metric_t *m = &exp->metrics[i];
+        const ecs_metric_t *metric = ECS_OFFSET(&exp->stats, m->offset);
+
+        sample->values[i] = m->counter ? metric->counter.value[t] : metric->gauge.avg[t];
+    }
+
+    sample->info = *ecs_get_world_info(ecs_get_world(w));
+
+    sample_clear(sample);
+    collect_systems(w, sample);
+
+    if(!exp->threaded)
+    {
+        write_sample(exp, sample);
+        return;
+    }
+
+    /* An unwritten sample is replaced, the system never waits for the writer */
+    ecs_os_mutex_lock(exp->lock);
+
+    exp->next = exp->ready;
+    exp->ready = sample;
+    exp->pending = true;
+
+    ecs_os_cond_signal(exp->cond);
+    ecs_os_mutex_unlock(exp->lock);
+}
+
+static void export_fini(void *ptr)
+{
+    ecs_lua_export_t *exp = ptr;
+    int32_t i;
+
+    if(exp->threaded)
+    {
+        ecs_os_mutex_lock(exp->lock);
+        exp->quit = true;
+        ecs_os_cond_signal(exp->cond);
+        ecs_os_mutex_unlock(exp->lock);
+
+        ecs_os_thread_join(exp->thread);
+
+        ecs_os_cond_free(exp->cond);
+        ecs_os_mutex_free(exp->lock);
+    }
+
+    for(i=0; i < 3; i++)
+    {
+        sample_clear(&exp->samples[i]);
+        ecs_vec_fini_t(NULL, &exp->samples[i].systems, ecs_lua_export_system_t);
+        ecs_os_free(exp->samples[i].values);
+    }
+
+    for(i=0; i < exp->metric_count; i++) ecs_os_free(exp->metrics[i].name);
+
+    ecs_os_free(exp->metrics);
+    ecs_os_free(exp->path);
+    ecs_os_free(exp);
+}
+
+static ecs_lua_export_t *export_init(ecs_world_t *w, const char *path)
+{
+    const EcsStruct *st = ecs_get(w, ecs_id(EcsLuaWorldStats), EcsStruct);
+    ecs_assert(st != NULL, ECS_INTERNAL_ERROR, NULL);
+
+    ecs_lua_export_t *exp = ecs_os_calloc(sizeof(ecs_lua_export_t));
+
+    exp->path = ecs_os_strdup(path);
+
+    const ecs_member_t *members = ecs_vec_first_t(&st->members, ecs_member_t);
+    int32_t i, count = ecs_vec_count(&st->members);
+
+    exp->metrics = ecs_os_calloc(count * ECS_SIZEOF(ecs_lua_export_metric_t));
+
+    for(i=0; i < count; i++)
+    {
+        const ecs_member_t *m = &members[i];
+
+        if(m->type != ecs_id(EcsLuaGauge) && m->type != ecs_id(EcsLuaCounter)) continue;
+
+        ecs_lua_export_metric_t *metric = &exp->metrics[exp->metric_count++];
+
+        metric->name = ecs_os_strdup(m->name);
+        metric->offset = m->offset;
+        metric->counter = m->type == ecs_id(EcsLuaCounter);
+    }
+
+    for(i=0; i < 3; i++)
+    {
+        exp->samples[i].values = ecs_os_calloc(exp->metric_count * ECS_SIZEOF(double));
+        ecs_vec_init_t(NULL, &exp->samples[i].systems, ecs_lua_export_system_t, 0);
+    }
+
+    exp->next = &exp->samples[0];
+    exp->ready = &exp->samples[1];
+    exp->work = &exp->samples[2];
+
+    exp->threaded = ecs_os_has_threading();
+
+    if(exp->threaded)
+    {
+        exp->lock = ecs_os_mutex_new();
+        exp->cond = ecs_os_cond_new();
+        exp->thread = ecs_os_thread_new(writer_thread, exp);
+    }
+
+    return exp;
+}
+
+int ecs_lua_export_stats(ecs_world_t *world, const char *path, ecs_ftime_t interval)
+{
+    ecs_entity_t parent = ecs_lookup_fullpath(world, "flecs.lua");
+    ecs_assert(parent != 0, ECS_INVALID_PARAMETER, "FlecsLua is not imported");
+    ecs_entity_t e = ecs_lookup_child(world, parent, "StatsExporter");
+
+    if(e) ecs_delete(world, e);
+
+    if(!path) return 0;
+
+    if(interval <= 0) return -1;
+
+    ecs_entity_desc_t edesc = {0};
+    edesc.name = "StatsExporter";
+    edesc.add[0] = ecs_pair(EcsChildOf, parent);
+    edesc.add[1] = ecs_dependson(EcsPostFrame);
+    edesc.add[2] = EcsPostFrame;
+
+    ecs_lua_export_t *exp = export_init(world, path);
+
+    ecs_system_desc_t desc = {0};
+    desc.entity = ecs_entity_init(world, &edesc);
+    desc.callback = ExportStats;
+    desc.interval = interval;
+    desc.ctx = exp;
+    desc.ctx_free = export_fini;
+
+    if(!ecs_system_init(world, &desc))
+    {
+        export_fini(exp);
+        return -1;
+    }
+
+    return 0;
+}
+
+int export_stats(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    const char *path = lua_isnoneornil(L, 1) ? NULL : luaL_checkstring(L, 1);
+    lua_Number interval = luaL_optnumber(L, 2, 1.0);
+
+    if(path && interval <= 0) return luaL_argerror(L, 2, "interval must be > 0");
+
+    if(ecs_lua_export_stats(w, path, interval)) return luaL_error(L, "failed to start stats exporter");
+
+    return 0;
+}
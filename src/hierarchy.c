@@ -1,21 +1,188 @@
 #include "private.h"
 
+/* Children include prefabs and disabled entities, as counted by ecs_count_id() */
+static ecs_iter_t children_iter(ecs_world_t *w, ecs_entity_t parent, ecs_filter_t *f)
+{
+    *f = ECS_FILTER_INIT;
+
+    ecs_filter_init(w, &(ecs_filter_desc_t)
+    {
+        .storage = f,
+        .terms = {{ .id = ecs_pair(EcsChildOf, parent), .inout = EcsInOutNone }},
+        .flags = EcsFilterMatchPrefab | EcsFilterMatchDisabled
+    });
+
+    return ecs_filter_iter(w, f);
+}
+
+/* Appends the children of parent to the array at idx, returns the new length */
+static int push_children(lua_State *L, ecs_world_t *w, ecs_entity_t parent, int idx, int n)
+{
+    ecs_filter_t f;
+    ecs_iter_t it = children_iter(w, parent, &f);
+
+    while(ecs_filter_next(&it))
+    {
+        int i;
+        for(i=0; i < it.count; i++)
+        {
+            lua_pushinteger(L, it.entities[i]);
+            lua_rawseti(L, idx, ++n);
+        }
+    }
+
+    ecs_filter_fini(&f);
+
+    return n;
+}
+
+typedef struct ecs_lua_subtree_t
+{
+    ecs_entity_t e;
+    lua_Integer depth;
+}ecs_lua_subtree_t;
+
+/* Depth-first (pre-order) variant of push_children(), iterative so deep
+   hierarchies don't overflow the C stack */
+static int push_subtree(lua_State *L, ecs_world_t *w, ecs_entity_t root, int idx, lua_Integer max_depth)
+{
+    ecs_vec_t stack;
+    ecs_vec_init_t(NULL, &stack, ecs_lua_subtree_t, 0);
+
+    ecs_lua_subtree_t *top = ecs_vec_append_t(NULL, &stack, ecs_lua_subtree_t);
+    top->e = root;
+    top->depth = 0;
+
+    int n = 0;
+
+    while(ecs_vec_count(&stack))
+    {
+        ecs_lua_subtree_t node = *ecs_vec_last_t(&stack, ecs_lua_subtree_t);
+        ecs_vec_remove_last(&stack);
+
+        if(node.depth)
+        {
+            lua_pushinteger(L, node.e);
+            lua_rawseti(L, idx, ++n);
+        }
+
+        if(max_depth && node.depth >= max_depth) continue;
+
+        /* Pushed in reverse so the first child is visited first */
+        int32_t i, j, start = ecs_vec_count(&stack);
+        ecs_filter_t f;
+        ecs_iter_t it = children_iter(w, node.e, &f);
+
+        while(ecs_filter_next(&it))
+        {
+            for(i=0; i < it.count; i++)
+            {
+                top = ecs_vec_append_t(NULL, &stack, ecs_lua_subtree_t);
+                top->e = it.entities[i];
+                top->depth = node.depth + 1;
+            }
+        }
+
+        ecs_filter_fini(&f);
+
+        ecs_lua_subtree_t *nodes = ecs_vec_first_t(&stack, ecs_lua_subtree_t);
+
+        for(i=start, j=ecs_vec_count(&stack) - 1; i < j; i++, j--)
+        {
+            ecs_lua_subtree_t tmp = nodes[i];
+            nodes[i] = nodes[j];
+            nodes[j] = tmp;
+        }
+    }
+
+    ecs_vec_fini_t(NULL, &stack, ecs_lua_subtree_t);
+
+    return n;
+}
+
 int get_child_count(lua_State *L)
 {
     ecs_world_t *w = ecs_lua_world(L);
 
     ecs_entity_t e = luaL_checkinteger(L, 1);
 
-    ecs_iter_t it = ecs_term_iter(w, &(ecs_term_t){ ecs_pair(EcsChildOf, e) });
+    int32_t count = ecs_count_id(w, ecs_pair(EcsChildOf, e));
+
+    lua_pushinteger(L, count);
+
+    return 1;
+}
+
+int children(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    ecs_entity_t e = luaL_checkinteger(L, 1);
+
+    int32_t count = ecs_count_id(w, ecs_pair(EcsChildOf, e));
+
+    lua_createtable(L, count, 0);
+
+    push_children(L, w, e, lua_gettop(L), 0);
+
+    return 1;
+}
+
+int descendants(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    ecs_entity_t e = luaL_checkinteger(L, 1);
+
+    bool depth_first = false;
+    lua_Integer max_depth = 0;
+
+    if(!lua_isnoneornil(L, 2))
+    {
+        luaL_checktype(L, 2, LUA_TTABLE);
+
+        lua_getfield(L, 2, "depth_first");
+        depth_first = lua_toboolean(L, -1);
 
-    int32_t count = 0;
+        if(lua_getfield(L, 2, "max_depth") != LUA_TNIL)
+        {
+            max_depth = luaL_checkinteger(L, -1);
 
-    while (ecs_term_next(&it))
+            if(max_depth < 1) luaL_argerror(L, 2, "max_depth must be >= 1");
+        }
+
+        lua_pop(L, 2);
+    }
+
+    lua_newtable(L);
+
+    int idx = lua_gettop(L);
+
+    if(depth_first)
     {
-        count += it.count;
+        push_subtree(L, w, e, idx, max_depth);
+        return 1;
     }
 
-    lua_pushinteger(L, count);
+    /* Breadth-first, the result is also the queue: [begin, end) is the current level */
+    int begin = 0, end = push_children(L, w, e, idx, 0);
+    int n = end, depth;
+
+    for(depth=1; begin < end && (!max_depth || depth < max_depth); depth++)
+    {
+        int i;
+        for(i=begin; i < end; i++)
+        {
+            lua_rawgeti(L, idx, i + 1);
+            ecs_entity_t parent = lua_tointeger(L, -1);
+            lua_pop(L, 1);
+
+            n = push_children(L, w, parent, idx, n);
+        }
+
+        begin = end;
+        end = n;
+    }
 
     return 1;
 }
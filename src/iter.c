@@ -131,6 +131,12 @@ int filter_iter(lua_State *L)
 
     ecs_iter_to_lua(&it, L, true);
 
+    /* The iterator references the filter */
+    lua_getmetatable(L, -1);
+    lua_pushvalue(L, -3);
+    lua_setfield(L, -2, "__ecs_filter");
+    lua_pop(L, 1);
+
     return 1;
 }
 
@@ -173,6 +179,80 @@ int term_next(lua_State *L)
     return 1;
 }
 
+/* Pushes an iterator that wraps the iterator at src,
+   which is kept alive by the new iterator's metatable */
+static void push_chained_iter(lua_State *L, ecs_iter_t *it, int src)
+{
+    ecs_iter_to_lua(it, L, true);
+
+    lua_getmetatable(L, -1);
+    lua_pushvalue(L, src);
+    lua_setfield(L, -2, "__ecs_chain");
+    lua_pop(L, 1);
+}
+
+int page_iter(lua_State *L)
+{
+    ecs_iter_t *it = ecs_lua__checkiter(L, 1);
+    lua_Integer offset = luaL_checkinteger(L, 2);
+    lua_Integer limit = luaL_checkinteger(L, 3);
+
+    luaL_argcheck(L, offset >= 0, 2, "offset must be >= 0");
+    luaL_argcheck(L, limit >= 0, 3, "limit must be >= 0");
+
+    ecs_iter_t pit = ecs_page_iter(it, offset, limit);
+
+    push_chained_iter(L, &pit, 1);
+
+    return 1;
+}
+
+int page_next(lua_State *L)
+{
+    ecs_iter_t *it = ecs_lua_to_iter(L, 1);
+
+    if(it->next != ecs_page_next) return luaL_argerror(L, 1, "not a page iterator");
+
+    int b = ecs_page_next(it);
+
+    if(b) ecs_lua_iter_update(L, 1, it);
+
+    lua_pushboolean(L, b);
+
+    return 1;
+}
+
+int worker_iter(lua_State *L)
+{
+    ecs_iter_t *it = ecs_lua__checkiter(L, 1);
+    lua_Integer index = luaL_checkinteger(L, 2);
+    lua_Integer count = luaL_checkinteger(L, 3);
+
+    luaL_argcheck(L, count > 0, 3, "count must be > 0");
+    luaL_argcheck(L, index >= 0 && index < count, 2, "index must be in [0, count)");
+
+    ecs_iter_t wit = ecs_worker_iter(it, index, count);
+
+    push_chained_iter(L, &wit, 1);
+
+    return 1;
+}
+
+int worker_next(lua_State *L)
+{
+    ecs_iter_t *it = ecs_lua_to_iter(L, 1);
+
+    if(it->next != ecs_worker_next) return luaL_argerror(L, 1, "not a worker iterator");
+
+    int b = ecs_worker_next(it);
+
+    if(b) ecs_lua_iter_update(L, 1, it);
+
+    lua_pushboolean(L, b);
+
+    return 1;
+}
+
 int iter_next(lua_State *L)
 {
     int b = ecs_lua_iter_next(L, 1);
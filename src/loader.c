@@ -0,0 +1,150 @@
+#include "private.h"
+
+#include <stdio.h>
+
+static char *read_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+
+    if(!f) return NULL;
+
+    char *buf = NULL;
+    long len;
+
+    if(fseek(f, 0, SEEK_END) || (len = ftell(f)) < 0 || fseek(f, 0, SEEK_SET)) goto error;
+
+    buf = ecs_os_malloc(len + 1);
+
+    if(fread(buf, 1, len, f) != (size_t)len) goto error;
+
+    fclose(f);
+
+    buf[len] = '\0';
+    *size = len;
+
+    return buf;
+
+error:
+    fclose(f);
+    ecs_os_free(buf);
+    return NULL;
+}
+
+/* FNV-1a, the path is part of the key since it ends up in the debug info */
+static uint64_t chunk_hash(const char *path, const char *src, size_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    const unsigned char *p = (const unsigned char*)path;
+
+    for(; *p; p++) hash = (hash ^ *p) * 1099511628211ULL;
+
+    hash = (hash ^ LUA_VERSION_NUM) * 1099511628211ULL;
+
+    size_t i;
+    p = (const unsigned char*)src;
+
+    for(i=0; i < size; i++) hash = (hash ^ p[i]) * 1099511628211ULL;
+
+    return hash;
+}
+
+static int dump_writer(lua_State *L, const void *p, size_t size, void *ud)
+{
+    return fwrite(p, 1, size, (FILE*)ud) != size;
+}
+
+/* Dump the function on top of the stack, the file is replaced atomically */
+static int store_bytecode(lua_State *L, const char *file)
+{
+    char *tmp = ecs_asprintf("%s.tmp", file);
+    FILE *f = fopen(tmp, "wb");
+    int err = 1;
+
+    if(f)
+    {
+        err = lua_dump(L, dump_writer, f, 0);
+        err |= fclose(f);
+
+        if(!err && rename(tmp, file))
+        {/* rename() does not replace existing files everywhere */
+            remove(file);
+            err = rename(tmp, file);
+        }
+
+        if(err) remove(tmp);
+    }
+
+    ecs_os_free(tmp);
+
+    return err;
+}
+
+int ecs_lua_load_cached(ecs_world_t *world, const char *path, const char *cache_dir)
+{
+    ecs_assert(path != NULL, ECS_INVALID_PARAMETER, NULL);
+
+    const EcsLuaHost *host = ecs_singleton_get(world, EcsLuaHost);
+
+    ecs_assert(host != NULL, ECS_INVALID_OPERATION, "FlecsLua is not imported");
+    if(!host) return LUA_ERRERR;
+
+    lua_State *L = host->L;
+    ecs_lua_ctx *ctx = host->ctx;
+
+    if(!cache_dir) return luaL_loadfilex(L, path, NULL);
+
+    size_t size;
+    char *src = read_file(path, &size);
+
+    if(!src)
+    {
+        lua_pushfstring(L, "cannot read %s", path);
+        return LUA_ERRFILE;
+    }
+
+    uint64_t hash = chunk_hash(path, src, size);
+    char *file = ecs_asprintf("%s/%016llx.luac", cache_dir, (unsigned long long)hash);
+
+    char *bytecode;
+    size_t bytecode_size;
+    int ret;
+
+    if((bytecode = read_file(file, &bytecode_size)))
+    {
+        ret = luaL_loadbufferx(L, bytecode, bytecode_size, path, "b");
+        ecs_os_free(bytecode);
+
+        if(ret == LUA_OK)
+        {
+            ctx->cache_stats.hits++;
+            goto done;
+        }
+
+        /* Stale or corrupt, most likely from a different Lua build */
+        lua_pop(L, 1);
+    }
+
+    ctx->cache_stats.misses++;
+
+    char *chunkname = ecs_asprintf("@%s", path);
+    ret = luaL_loadbufferx(L, src, size, chunkname, NULL);
+    ecs_os_free(chunkname);
+
+    if(ret == LUA_OK && store_bytecode(L, file)) ctx->cache_stats.errors++;
+
+done:
+    ecs_os_free(file);
+    ecs_os_free(src);
+
+    return ret;
+}
+
+void ecs_lua_cache_stats(ecs_world_t *world, ecs_lua_cache_stats_t *stats)
+{
+    ecs_assert(stats != NULL, ECS_INVALID_PARAMETER, NULL);
+
+    const EcsLuaHost *host = ecs_singleton_get(world, EcsLuaHost);
+
+    if(host && host->ctx) *stats = host->ctx->cache_stats;
+    else *stats = (ecs_lua_cache_stats_t){0};
+}
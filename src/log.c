@@ -1,10 +1,196 @@
 #include "private.h"
 
+#include <stdio.h>
+
 #define ECS_LUA__LOG 0
 #define ECS_LUA__ERROR 1
 #define ECS_LUA__DEBUG 2
 #define ECS_LUA__WARN 3
 
+#define ECS_LUA_LOG_MSG (480)
+#define ECS_LUA_LOG_SITES (256)
+
+/* flecs log level of each message type */
+static const int log_levels[] = { 0, -3, 1, -2 };
+static const char *log_names[] = { "info", "error", "debug", "warning" };
+
+typedef struct ecs_lua_log_msg_t
+{
+    int32_t type;
+    char text[ECS_LUA_LOG_MSG]; /* "file:line: message" */
+}ecs_lua_log_msg_t;
+
+typedef struct ecs_lua_log_site_t
+{
+    char source[LUA_IDSIZE]; /* short_src, copied since the chunk may be collected */
+    int32_t line;
+    int32_t count;
+    int32_t suppressed;
+    double window;
+}ecs_lua_log_site_t;
+
+/* Ring buffer written to a file by a background thread. Userdata in
+   registry[&logger_key], each Lua state has its own logger so messages
+   are only pushed by the thread running the state */
+typedef struct ecs_lua_logger_t
+{
+    FILE *file;
+
+    /* Messages per second per call site, 0 is unlimited */
+    int32_t rate;
+    ecs_lua_log_site_t sites[ECS_LUA_LOG_SITES];
+    ecs_time_t start;
+
+    ecs_os_mutex_t lock;
+    ecs_os_cond_t cond; /* Message pushed or quit */
+
+    int32_t head; /* Producer */
+    int32_t tail; /* Consumer */
+    int32_t count;
+    int32_t dropped;
+    int32_t capacity;
+    ecs_lua_log_msg_t *msgs;
+
+    bool threaded, quit;
+    ecs_os_thread_t thread;
+}ecs_lua_logger_t;
+
+static const char logger_key = 'l';
+
+static ecs_lua_logger_t *get_logger(lua_State *L)
+{
+    ecs_lua_logger_t *lg = NULL;
+
+    if(lua_rawgetp(L, LUA_REGISTRYINDEX, &logger_key) == LUA_TUSERDATA) lg = lua_touserdata(L, -1);
+
+    lua_pop(L, 1);
+
+    return lg;
+}
+
+static void write_msg(ecs_lua_logger_t *lg, const ecs_lua_log_msg_t *msg)
+{
+    fprintf(lg->file, "%s: %s\n", log_names[msg->type], msg->text);
+}
+
+static void *log_writer(void *arg)
+{
+    ecs_lua_logger_t *lg = arg;
+    ecs_lua_log_msg_t msg;
+
+    ecs_os_mutex_lock(lg->lock);
+
+    for(;;)
+    {
+        if(!lg->count)
+        {
+            if(lg->quit) break;
+
+            /* Flush once the queue is drained, not for every message */
+            ecs_os_mutex_unlock(lg->lock);
+            fflush(lg->file);
+            ecs_os_mutex_lock(lg->lock);
+
+            while(!lg->count && !lg->quit) ecs_os_cond_wait(lg->cond, lg->lock);
+
+            continue;
+        }
+
+        msg = lg->msgs[lg->tail];
+
+        lg->tail = (lg->tail + 1) % lg->capacity;
+        lg->count--;
+
+        ecs_os_mutex_unlock(lg->lock);
+
+        write_msg(lg, &msg);
+
+        ecs_os_mutex_lock(lg->lock);
+    }
+
+    ecs_os_mutex_unlock(lg->lock);
+
+    return NULL;
+}
+
+static void push_msg(ecs_lua_logger_t *lg, int type, const char *src, int line, const char *str)
+{
+    if(!lg->threaded)
+    {
+        fprintf(lg->file, "%s: %s:%d: %s\n", log_names[type], src, line, str);
+        return;
+    }
+
+    ecs_os_mutex_lock(lg->lock);
+
+    /* Never block the main thread on the file, drop the message instead */
+    if(lg->count == lg->capacity)
+    {
+        lg->dropped++;
+        ecs_os_mutex_unlock(lg->lock);
+        return;
+    }
+
+    ecs_lua_log_msg_t *msg = &lg->msgs[lg->head];
+
+    msg->type = type;
+    snprintf(msg->text, ECS_LUA_LOG_MSG, "%s:%d: %s", src, line, str);
+
+    lg->head = (lg->head + 1) % lg->capacity;
+    lg->count++;
+
+    ecs_os_cond_signal(lg->cond);
+    ecs_os_mutex_unlock(lg->lock);
+}
+
+static void push_suppressed(ecs_lua_logger_t *lg, ecs_lua_log_site_t *site)
+{
+    char note[64];
+    snprintf(note, sizeof(note), "%d messages suppressed", site->suppressed);
+    push_msg(lg, ECS_LUA__WARN, site->source, site->line, note);
+
+    site->suppressed = 0;
+}
+
+/* Returns false if the call site exceeded its rate for the current second */
+static bool log_allowed(ecs_lua_logger_t *lg, const lua_Debug *ar)
+{
+    if(!lg->rate) return true;
+
+    /* short_src is empty if there is no Lua caller */
+    const char *p;
+    uint32_t h = (uint32_t)ar->currentline * 2654435761u;
+
+    for(p = ar->short_src; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+
+    ecs_lua_log_site_t *site = &lg->sites[(h ^ (h >> 16)) % ECS_LUA_LOG_SITES];
+
+    ecs_time_t now = lg->start;
+    double t = ecs_time_measure(&now);
+
+    if(site->line != ar->currentline || strcmp(site->source, ar->short_src) || t - site->window >= 1.0)
+    {
+        if(site->suppressed) push_suppressed(lg, site);
+
+        ecs_os_strncpy(site->source, ar->short_src, LUA_IDSIZE - 1);
+        site->source[LUA_IDSIZE - 1] = '\0';
+        site->line = ar->currentline;
+        site->count = 0;
+        site->suppressed = 0;
+        site->window = t;
+    }
+
+    if(site->count >= lg->rate)
+    {
+        site->suppressed++;
+        return false;
+    }
+
+    site->count++;
+
+    return true;
+}
+
 int vararg2str(lua_State *L, int n, ecs_strbuf_t *buf)
 {
     lua_getglobal(L, "tostring");
@@ -31,11 +217,18 @@ int vararg2str(lua_State *L, int n, ecs_strbuf_t *buf)
 
 static int print_type(lua_State *L, int type)
 {
+    /* Skip formatting for messages the log level would discard */
+    if(log_levels[type] > ecs_os_api.log_level_) return 0;
+
     int level = 1;
     lua_Debug ar = {0};
 
     if(lua_getstack(L, level, &ar)) lua_getinfo(L, "Sl", &ar);
 
+    ecs_lua_logger_t *logger = get_logger(L);
+
+    if(logger && !log_allowed(logger, &ar)) return 0;
+
     int n = lua_gettop(L);
 
     ecs_strbuf_t buf = ECS_STRBUF_INIT;
@@ -44,6 +237,13 @@ static int print_type(lua_State *L, int type)
 
     char *str = ecs_strbuf_get(&buf);
 
+    if(logger)
+    {
+        push_msg(logger, type, ar.short_src, ar.currentline, str ? str : "");
+        ecs_os_free(str);
+        return 0;
+    }
+
     switch(type)
     {
         case ECS_LUA__LOG:
@@ -103,4 +303,108 @@ int log_enable_colors(lua_State *L)
     ecs_log_enable_colors(enable);
 
     return 0;
-}
\ No newline at end of file
+}
+
+/* Writes pending suppression notes and the queued messages, closes the file */
+static void logger_close(ecs_lua_logger_t *lg)
+{
+    if(!lg->file) return;
+
+    int i;
+    for(i=0; i < ECS_LUA_LOG_SITES; i++)
+    {
+        if(lg->sites[i].suppressed) push_suppressed(lg, &lg->sites[i]);
+    }
+
+    if(lg->threaded)
+    {
+        ecs_os_mutex_lock(lg->lock);
+        lg->quit = true;
+        ecs_os_cond_signal(lg->cond);
+        ecs_os_mutex_unlock(lg->lock);
+
+        /* The writer drains the queue before it exits */
+        ecs_os_thread_join(lg->thread);
+
+        ecs_os_cond_free(lg->cond);
+        ecs_os_mutex_free(lg->lock);
+        ecs_os_free(lg->msgs);
+    }
+
+    fclose(lg->file);
+
+    lg->file = NULL;
+}
+
+int logger_gc(lua_State *L)
+{
+    ecs_lua_logger_t *lg = luaL_checkudata(L, 1, "ecs_logger_t");
+
+    logger_close(lg);
+
+    return 0;
+}
+
+int log_open(lua_State *L)
+{
+    const char *path = luaL_checkstring(L, 1);
+    lua_Integer capacity = 1024, rate = 0;
+
+    if(!lua_isnoneornil(L, 2))
+    {
+        luaL_checktype(L, 2, LUA_TTABLE);
+
+        if(lua_getfield(L, 2, "capacity") != LUA_TNIL) capacity = luaL_checkinteger(L, -1);
+        if(lua_getfield(L, 2, "rate") != LUA_TNIL) rate = luaL_checkinteger(L, -1);
+
+        lua_pop(L, 2);
+    }
+
+    if(capacity < 1 || capacity > (1 << 20)) return luaL_argerror(L, 2, "capacity out of range");
+    if(rate < 0 || rate > INT32_MAX) return luaL_argerror(L, 2, "rate out of range");
+
+    if(get_logger(L)) return luaL_error(L, "log file is already open");
+
+    ecs_lua_logger_t *lg = lua_newuserdata(L, sizeof(ecs_lua_logger_t));
+    memset(lg, 0, sizeof(ecs_lua_logger_t));
+
+    luaL_setmetatable(L, "ecs_logger_t");
+
+    FILE *f = fopen(path, "ab");
+
+    if(!f) return luaL_error(L, "cannot open %s", path);
+
+    lg->file = f;
+    lg->rate = (int32_t)rate;
+    lg->capacity = (int32_t)capacity;
+    lg->threaded = ecs_os_has_threading();
+    ecs_os_get_time(&lg->start);
+
+    if(lg->threaded)
+    {
+        lg->msgs = ecs_os_malloc(lg->capacity * ECS_SIZEOF(ecs_lua_log_msg_t));
+        lg->lock = ecs_os_mutex_new();
+        lg->cond = ecs_os_cond_new();
+        lg->thread = ecs_os_thread_new(log_writer, lg);
+    }
+
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &logger_key);
+
+    return 0;
+}
+
+int log_close(lua_State *L)
+{
+    ecs_lua_logger_t *lg = get_logger(L);
+
+    if(!lg) return 0;
+
+    logger_close(lg);
+
+    lua_pushinteger(L, lg->dropped);
+
+    lua_pushnil(L);
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &logger_key);
+
+    return 1;
+}
@@ -12,13 +12,18 @@ typedef struct ecs_lua_col_t
     ecs_meta_cursor_t *cursor;
 }ecs_lua_col_t;
 
-typedef struct ecs_lua_each_t
+struct ecs_lua_each_t
 {
     ecs_iter_t *it;
     int32_t i;
     bool from_query, read_prev;
+
+    /* Query iteration state, reused by ecs.each(query) */
+    bool active, changed_only;
+    ecs_iter_t storage;
+
     ecs_lua_col_t cols[];
-}ecs_lua_each_t;
+};
 
 static
 void serialize_type_op(
@@ -243,13 +248,7 @@ void serialize_vector(
     const void *base,
     lua_State *L)
 {
-    ecs_vec_t *value = *(ecs_vec_t**)base;
-
-    if(!value)
-    {
-        lua_pushnil(L);
-        return;
-    }
+    const ecs_vec_t *value = base;
 
     const EcsVector *v = ecs_get(world, op->type, EcsVector);
     ecs_assert(v != NULL, ECS_INTERNAL_ERROR, NULL);
@@ -258,11 +257,48 @@ void serialize_vector(
     ecs_assert(comp != NULL, ECS_INTERNAL_ERROR, NULL);
 
     int32_t count = ecs_vec_count(value);
-    void *array = ecs_vec_first(value);
+    const void *array = ecs_vec_first(value);
 
     serialize_type_elements(world, v->type, array, count, L);
 }
 
+int ecs_lua_member(
+    const ecs_world_t *world,
+    ecs_entity_t type,
+    const char *path,
+    ecs_entity_t *member_type,
+    int32_t *offset)
+{
+    static const char base;
+
+    ecs_meta_cursor_t c = ecs_meta_cursor(world, type, (void*)&base);
+
+    char name[128];
+    const char *ptr = path;
+
+    for(;;)
+    {
+        const char *dot = strchr(ptr, '.');
+        size_t len = dot ? (size_t)(dot - ptr) : strlen(ptr);
+
+        if(len >= sizeof(name)) return -1;
+
+        memcpy(name, ptr, len);
+        name[len] = '\0';
+
+        if(ecs_meta_push(&c) || ecs_meta_member(&c, name)) return -1;
+
+        if(!dot) break;
+
+        ptr = dot + 1;
+    }
+
+    *member_type = ecs_meta_get_type(&c);
+    *offset = (int32_t)((const char*)ecs_meta_get_ptr(&c) - &base);
+
+    return 0;
+}
+
 static
 void serialize_type_op(
     const ecs_world_t *world,
@@ -640,6 +676,22 @@ static void deserialize_type(lua_State *L, int idx, ecs_meta_cursor_t *c, int de
             {
                 ecs_lua_dbg_pad(depth);
                 ecs_lua_dbg("set_string: %s", lua_tostring(L, -1));
+
+                /* Keep the current allocation if the value did not change */
+                ecs_meta_scope_t *scope = &c->scope[c->depth];
+                ecs_meta_type_op_t *op = &scope->ops[scope->op_cur];
+
+                if(op->kind == EcsOpString)
+                {
+                    const char *cur = *(char**)ecs_meta_get_ptr(c);
+
+                    if(cur && !strcmp(cur, lua_tostring(L, -1)))
+                    {
+                        lua_pop(L, 1);
+                        continue;
+                    }
+                }
+
                 ret = ecs_meta_set_string(c, lua_tostring(L, -1));
 
                 ecs_assert(!ret, ECS_INTERNAL_ERROR, NULL);
@@ -727,6 +779,95 @@ static int columns__len(lua_State *L)
     return 1;
 }
 
+/* Pushes the cached columns of the table, registry[world][columns] = { [table] = { [offset] = { [id] = column } } }.
+   The cache is reset when a frame or merge completes, returns false (and pushes nothing) if create is false
+   and the table has no cached columns. Columns written by C systems during the frame are not detected */
+static bool push_column_cache(lua_State *L, const ecs_world_t *world, ecs_table_t *table, bool create)
+{
+    const ecs_world_info_t *info = ecs_get_world_info(world);
+    lua_Integer epoch = ((lua_Integer)info->frame_count_total << 32) | (uint32_t)info->merge_count_total;
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, world);
+
+    if(lua_rawgeti(L, -1, ECS_LUA_COLUMNS) != LUA_TTABLE)
+    {
+        lua_pop(L, 1);
+
+        if(!create)
+        {
+            lua_pop(L, 1);
+            return false;
+        }
+
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, -3, ECS_LUA_COLUMNS);
+    }
+
+    lua_getfield(L, -1, "epoch");
+
+    if(lua_tointeger(L, -1) != epoch)
+    {
+        lua_pop(L, 2);
+
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, -3, ECS_LUA_COLUMNS);
+
+        lua_pushinteger(L, epoch);
+        lua_setfield(L, -2, "epoch");
+    }
+    else lua_pop(L, 1);
+
+    if(lua_rawgetp(L, -1, table) != LUA_TTABLE)
+    {
+        lua_pop(L, 1);
+
+        if(!create)
+        {
+            lua_pop(L, 2);
+            return false;
+        }
+
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_rawsetp(L, -3, table);
+    }
+
+    lua_replace(L, -3);
+    lua_pop(L, 1);
+
+    return true;
+}
+
+/* Drops the cached column of a table that was written, at all offsets */
+static void column_cache_invalidate(lua_State *L, const ecs_world_t *world, ecs_table_t *table, ecs_id_t id)
+{
+    if(!push_column_cache(L, world, table, false)) return;
+
+    lua_pushnil(L);
+
+    while(lua_next(L, -2))
+    {
+        lua_pushnil(L);
+        lua_rawseti(L, -2, id);
+        lua_pop(L, 1);
+    }
+
+    lua_pop(L, 1);
+}
+
+/* Read-only columns of systems created with { cache_columns = true },
+   they are not written back */
+static bool column_cacheable(const ecs_iter_t *it, int32_t i)
+{
+    if(!it->system || !it->binding_ctx || !it->table || it->next != ecs_query_next) return false;
+
+    const ecs_lua_callback *cb = it->binding_ctx;
+
+    return cb->cache_columns && ecs_field_is_self(it, i) && ecs_field_is_readonly(it, i);
+}
+
 static int columns__index(lua_State *L)
 {
     ecs_iter_t *it = lua_touserdata(L, lua_upvalueindex(1));
@@ -750,10 +891,47 @@ static int columns__index(lua_State *L)
     lua_settop(L, 1); /* (it.)columns */
 
     const void *base = ecs_field_w_size(it, 0, i);
+    ecs_id_t id = ecs_field_id(it, i);
+    bool cache = column_cacheable(it, i);
+
+    if(cache)
+    {
+        push_column_cache(L, ecs_get_world(world), it->table, true);
+
+        /* Columns of the same table are iterated in ranges by some systems */
+        if(lua_rawgeti(L, -1, it->offset) != LUA_TTABLE)
+        {
+            lua_pop(L, 1);
+            lua_newtable(L);
+            lua_pushvalue(L, -1);
+            lua_rawseti(L, -3, it->offset);
+        }
+
+        lua_remove(L, -2);
+
+        if(lua_rawgeti(L, -1, id) == LUA_TTABLE && luaL_len(L, -1) == it->count)
+        {
+            lua_remove(L, -2);
+            goto done;
+        }
+
+        lua_pop(L, 1);
+    }
 
     if(!ecs_field_is_self(it, i)) serialize_type(world, &ser->ops, base, L);
     else serialize_column(world, L, ser, base, it->count);
 
+    if(cache)
+    {
+        /* Shared with other systems */
+        ecs_lua_readonly(L);
+
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, -3, id);
+        lua_remove(L, -2);
+    }
+
+done:
     lua_pushvalue(L, -1);
     lua_rawseti(L, -3, i);
 
@@ -836,6 +1014,9 @@ static void push_iter_metadata(lua_State *L, ecs_iter_t *it)
     lua_pushinteger(L, it->term_index);
     lua_setfield(L, -2, "term_index");
 
+    lua_pushinteger(L, it->group_id);
+    lua_setfield(L, -2, "group_id");
+
     if(it->system)
     {
         ecs_lua_callback *sys = it->binding_ctx;
@@ -869,11 +1050,35 @@ static void push_iter_metadata(lua_State *L, ecs_iter_t *it)
     lua_setfield(L, -2, "entities");
 }
 
+/* Lazily evaluated iterator fields */
+static int iter__index(lua_State *L)
+{
+    const char *key = lua_tostring(L, 2);
+
+    if(key && !strcmp(key, "changed"))
+    {
+        ecs_iter_t *it = ecs_lua__checkiter(L, 1);
+
+        /* Whether the current table changed since it was last iterated */
+        if(it->next == ecs_query_next && ECS_BIT_IS_SET(it->flags, EcsIterIsValid))
+            lua_pushboolean(L, ecs_query_changed(it->priv.iter.query.query, it));
+        else
+            lua_pushnil(L);
+
+        return 1;
+    }
+
+    return 0;
+}
+
 /* expects table at stack top */
 static ecs_iter_t *push_iter_metafield(lua_State *L, ecs_iter_t *it, bool copy)
 {
     /* metatable */
-    lua_createtable(L, 0, 1);
+    lua_createtable(L, 0, 2);
+
+    lua_pushcfunction(L, iter__index);
+    lua_setfield(L, -2, "__index");
 
     /* metatable.__ecs_iter = it */
     if(copy)
@@ -1049,7 +1254,12 @@ ecs_iter_t *ecs_lua_to_iter(lua_State *L, int idx)
         void *base = ecs_field_w_size(it, 0, i);
 
         if(!is_owned) ecs_lua_to_ptr(world, L, -1, column_entity, base);
-        else deserialize_column(world, L, -1, column_entity, base, ecs_field_size(it, i), count);
+        else
+        {
+            deserialize_column(world, L, -1, column_entity, base, ecs_field_size(it, i), count);
+
+            if(it->table) column_cache_invalidate(L, real_world, it->table, ecs_field_id(it, i));
+        }
 
         lua_pop(L, 1); /* columns[i] */
     }
@@ -1079,8 +1289,19 @@ void ecs_lua_iter_update(lua_State *L, int idx, ecs_iter_t *it)
 bool ecs_lua_iter_next(lua_State *L, int idx)
 {ecs_lua_dbg("ITER_NEXT");
     ecs_iter_t *it = ecs_lua_to_iter(L, idx);
+    bool changed_only = it->next == ecs_query_next && luaL_getmetafield(L, idx, "__ecs_changed") != LUA_TNIL;
 
-    if(!ecs_iter_next(it)) return false;
+    if(changed_only) lua_pop(L, 1);
+
+    if(!(changed_only ? ecs_lua_query_next(it, true) : ecs_iter_next(it)))
+    {/* The iterator finalized itself, checked by run systems */
+        lua_getmetatable(L, idx);
+        lua_pushboolean(L, 1);
+        lua_setfield(L, -2, "__ecs_done");
+        lua_pop(L, 1);
+
+        return false;
+    }
 
     ecs_lua_iter_update(L, idx, it);
 
@@ -1183,8 +1404,12 @@ skip_readback:
     {
         if(each->from_query)
         {
-            if(ecs_lua_iter_next(L, 1)) each_reset_columns(L, each);
-            else end = true;
+            if(ecs_lua_query_next(it, each->changed_only)) each_reset_columns(L, each);
+            else
+            {
+                each->active = false;
+                end = true;
+            }
         }
         else end = true;
     }
@@ -1223,55 +1448,139 @@ static int is_primitive(const EcsMetaTypeSerialized *ser)
     return 0;
 }
 
-int each_func(lua_State *L)
-{ecs_lua_dbg("ecs.each()");
-    ecs_world_t *w = ecs_lua_world(L);
-    ecs_query_t *q = NULL;
-    ecs_iter_t *it;
-    int iter_idx = 1;
+/* Pushes the next_func closure for a new state */
+static ecs_lua_each_t *new_each(lua_State *L, ecs_iter_t *it, int32_t field_count)
+{
+    size_t size = sizeof(ecs_lua_each_t) + field_count * sizeof(ecs_lua_col_t);
+    ecs_lua_each_t *each = lua_newuserdata(L, size);
 
-    if(lua_type(L, 1) == LUA_TUSERDATA)
+    luaL_setmetatable(L, "ecs_each_t");
+
+    each->it = it ? it : &each->storage;
+    each->i = 0;
+    each->from_query = it ? false : true;
+    each->read_prev = false;
+    each->active = false;
+
+    int i;
+    for(i=0; i < field_count; i++) lua_newtable(L);
+
+    lua_pushcclosure(L, next_func, field_count + 1);
+
+    return each;
+}
+
+static bool each_query_start(lua_State *L, ecs_world_t *w, ecs_lua_query_t *q, ecs_lua_each_t *each, bool changed_only)
+{
+    each->storage = ecs_lua_query_iter(L, w, q);
+    each->read_prev = false;
+    each->changed_only = changed_only;
+
+    if(!ecs_lua_query_next(&each->storage, changed_only)) return false;
+
+    each->active = true;
+    each_reset_columns(L, each);
+
+    return true;
+}
+
+/* Iterators allocate from a stack, they must be finalized in LIFO order.
+   Loops are closed innermost first so __close can finalize synchronously */
+int each__close(lua_State *L)
+{
+    ecs_lua_each_t *each = luaL_checkudata(L, 1, "ecs_each_t");
+
+    if(each->active) ecs_iter_fini(&each->storage);
+
+    each->active = false;
+
+    return 0;
+}
+
+/* An abandoned iterator is not finalized, it is out of order by now.
+   Its stack memory is released with the iterators that preceded it */
+int each__gc(lua_State *L)
+{
+    ecs_lua_each_t *each = luaL_checkudata(L, 1, "ecs_each_t");
+
+    each->active = false;
+
+    return 0;
+}
+
+/* The query owns one iteration state which is reused as long as the
+   previous loop has completed, this avoids creating a new closure and
+   column tables on every call. The state is returned as the to-be-closed
+   variable of the loop (Lua 5.4), loops exited early release it then.
+   Nested loops, and loops after an early exit without __close (Lua 5.3)
+   get a temporary state. */
+static int each_query(lua_State *L, ecs_world_t *w, ecs_lua_query_t *q, bool changed_only)
+{
+    ecs_lua_each_t *each = q->each;
+
+    if(each && !each->active)
+    {
+        ecs_lua_rawgeti(L, w, q->each_ref);
+    }
+    else
     {
-        q = checkquery(L, 1);
-        ecs_iter_t iter = ecs_query_iter(w, q);
-        int b = ecs_query_next(&iter); // XXX: will next_func iterate and skip data?
-
-        if(!b) /* no matching entities */
-        {/* must return an iterator, push one that ends it immediately */
-            lua_pushcfunction(L, empty_next_func);
-            lua_pushinteger(L, 0);
-            lua_pushinteger(L, 1);
-            return 3;
+        each = new_each(L, NULL, ecs_query_get_filter(q->query)->field_count);
+
+        if(!q->each)
+        {
+            lua_pushvalue(L, -1);
+            q->each_ref = ecs_lua_ref(L, w);
+            q->each = each;
         }
+    }
+
+    if(!each_query_start(L, w, q, each, changed_only))
+    {/* must return an iterator, push one that ends it immediately */
+        lua_pop(L, 1);
+        lua_pushcfunction(L, empty_next_func);
 
-        it = ecs_iter_to_lua(&iter, L, true);
-        iter_idx = lua_gettop(L);
+        return 1;
     }
-    else it = ecs_lua__checkiter(L, 1);
 
-    size_t size = sizeof(ecs_lua_each_t) + it->field_count * sizeof(ecs_lua_col_t);
-    ecs_lua_each_t *each = lua_newuserdata(L, size);
+    /* next_func, nil, nil, state (closing value) */
+    lua_pushnil(L);
+    lua_pushnil(L);
+    lua_getupvalue(L, -3, 1);
 
-    each->it = it;
-    each->from_query = q ? true : false;
-    each->read_prev = false;
+    return 4;
+}
 
-    each_reset_columns(L, each);
+int each_func(lua_State *L)
+{ecs_lua_dbg("ecs.each()");
+    ecs_world_t *w = ecs_lua_world(L);
 
-    int i;
-    for(i=1; i <= it->field_count; i++)
+    if(lua_type(L, 1) == LUA_TUSERDATA)
     {
-        lua_newtable(L);
+        ecs_lua_query_t *q = ecs_lua__checkquery(L, 1);
+
+        ecs_lua_check_world(L, w, 1);
+
+        bool changed_only = false;
+
+        if(!lua_isnoneornil(L, 2))
+        {
+            luaL_checktype(L, 2, LUA_TTABLE);
 
-        const EcsMetaTypeSerialized *ser = each->cols[i].ser;
-        //if(!ser) luaL_error(L, "col");
-        //if(is_primitive(ser)) luaL_error(L, "primitive");
+            lua_getfield(L, 2, "changed");
+            changed_only = lua_toboolean(L, -1);
+            lua_pop(L, 1);
+        }
+
+        return each_query(L, w, q, changed_only);
     }
 
-    lua_pushcclosure(L, next_func, it->field_count + 1);
+    ecs_iter_t *it = ecs_lua__checkiter(L, 1);
+    ecs_lua_each_t *each = new_each(L, it, it->field_count);
+
+    each_reset_columns(L, each);
 
     /* it */
-    lua_pushvalue(L, iter_idx);
+    lua_pushvalue(L, 1);
 
     lua_pushinteger(L, 1);
 
@@ -70,19 +70,164 @@ int check_filter_desc(lua_State *L, const ecs_world_t *world, ecs_filter_desc_t
     return 0;
 }
 
-ecs_filter_t *checkfilter(lua_State *L, const ecs_world_t *world, int arg)
+int filter_gc(lua_State *L)
+{
+    ecs_filter_t **ptr = luaL_checkudata(L, 1, "ecs_filter_t");
+
+    if(*ptr) ecs_filter_fini(*ptr);
+
+    *ptr = NULL;
+
+    return 0;
+}
+
+/* Compiles the filter descriptor or expression at arg, pushes the filter object */
+static ecs_filter_t *push_filter(lua_State *L, ecs_world_t *world, int arg)
 {
     ecs_filter_desc_t filter_desc = {0};
 
-    check_filter_desc(L, world, &filter_desc, arg);
+    if(lua_type(L, arg) == LUA_TSTRING) filter_desc.expr = lua_tostring(L, arg);
+    else check_filter_desc(L, world, &filter_desc, arg);
 
     ecs_filter_t *filter = ecs_filter_init(world, &filter_desc);
 
     if(!filter) luaL_argerror(L, arg, "invalid filter");
 
+    ecs_filter_t **ptr = lua_newuserdata(L, sizeof(ecs_filter_t*));
+    *ptr = filter;
+
+    /* Associate world with the object for sanity checks */
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_setuservalue(L, -2);
+
+    luaL_setmetatable(L, "ecs_filter_t");
+
+    /* Filters are weak keys of the cache so unreachable filters can be
+       collected, the remaining ones are finalized with the world */
+    lua_rawgetp(L, LUA_REGISTRYINDEX, ecs_get_world(world));
+    lua_rawgeti(L, -1, ECS_LUA_FILTERS);
+    lua_pushvalue(L, -3);
+    lua_pushboolean(L, 1);
+    lua_rawset(L, -3); /* filters[filter] = true */
+    lua_pop(L, 2);
+
     return filter;
 }
 
+/* Expression keys are strong, they are dropped when the cache is full */
+static void cache_expr(lua_State *L, int cache)
+{
+    lua_rawgeti(L, cache, 0);
+    lua_Integer count = lua_tointeger(L, -1);
+    lua_pop(L, 1);
+
+    if(count >= ECS_LUA_FILTER_CACHE_MAX)
+    {
+        lua_pushnil(L);
+
+        while(lua_next(L, cache))
+        {
+            lua_pop(L, 1);
+
+            if(lua_type(L, -1) != LUA_TSTRING) continue;
+
+            lua_pushvalue(L, -1);
+            lua_pushnil(L);
+            lua_rawset(L, cache);
+        }
+
+        count = 0;
+    }
+
+    lua_pushinteger(L, count + 1);
+    lua_rawseti(L, cache, 0);
+}
+
+/* Pushes the cache key for the filter at arg: the expression string
+   for strings and { expr = "..." } tables, the value itself otherwise */
+static void push_filter_key(lua_State *L, int arg)
+{
+    if(lua_type(L, arg) == LUA_TTABLE)
+    {
+        int terms_type = lua_getfield(L, arg, "terms");
+        int expr_type = lua_getfield(L, arg, "expr");
+
+        lua_remove(L, -2);
+
+        if(terms_type == LUA_TNIL && expr_type == LUA_TSTRING) return;
+
+        lua_pop(L, 1);
+    }
+
+    lua_pushvalue(L, arg);
+}
+
+ecs_filter_t *checkfilter(lua_State *L, ecs_world_t *world, int arg)
+{
+    arg = lua_absindex(L, arg);
+
+    ecs_filter_t **ptr = luaL_testudata(L, arg, "ecs_filter_t");
+
+    if(ptr)
+    {
+        if(!*ptr) luaL_argerror(L, arg, "filter was collected");
+
+        ecs_lua_check_world(L, world, arg);
+
+        lua_pushvalue(L, arg);
+        return *ptr;
+    }
+
+    int type = lua_type(L, arg);
+
+    if(type != LUA_TSTRING && type != LUA_TTABLE) luaL_argerror(L, arg, "expected filter");
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, ecs_get_world(world));
+    lua_rawgeti(L, -1, ECS_LUA_FILTERS);
+    lua_remove(L, -2);
+
+    int cache = lua_absindex(L, -1);
+
+    push_filter_key(L, arg);
+
+    if(lua_rawget(L, cache) == LUA_TUSERDATA)
+    {
+        ptr = lua_touserdata(L, -1);
+
+        if(*ptr)
+        {
+            lua_remove(L, cache);
+            return *ptr;
+        }
+    }
+
+    lua_pop(L, 1);
+
+    ecs_filter_t *filter = push_filter(L, world, arg);
+
+    push_filter_key(L, arg);
+
+    if(lua_type(L, -1) == LUA_TSTRING) cache_expr(L, cache);
+
+    lua_pushvalue(L, -2);
+    lua_rawset(L, cache); /* filters[key] = filter */
+
+    lua_remove(L, cache);
+
+    return filter;
+}
+
+int filter_new(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    luaL_checkany(L, 1);
+
+    push_filter(L, w, 1);
+
+    return 1;
+}
+
 int assert_func(lua_State *L)
 {
     if(lua_toboolean(L, 1)) return lua_gettop(L);
@@ -157,6 +302,76 @@ int ecs_lua__readonly(lua_State *L)
     return luaL_error(L, "Attempt to modify read-only table");
 }
 
+/* Read-only proxies keep the proxied table at proxy[&readonly_key] */
+static const int readonly_key;
+
+static void push_proxied(lua_State *L, int idx)
+{
+    lua_rawgetp(L, idx, &readonly_key);
+}
+
+int ecs_lua__readonly_index(lua_State *L)
+{
+    push_proxied(L, 1);
+    lua_pushvalue(L, 2);
+    lua_rawget(L, -2);
+
+    return 1;
+}
+
+int ecs_lua__readonly_len(lua_State *L)
+{
+    push_proxied(L, 1);
+    lua_pushinteger(L, lua_rawlen(L, -1));
+
+    return 1;
+}
+
+static int readonly_next(lua_State *L)
+{
+    push_proxied(L, 1);
+    lua_pushvalue(L, 2);
+
+    if(lua_next(L, -2)) return 2;
+
+    lua_pushnil(L);
+
+    return 1;
+}
+
+int ecs_lua__readonly_pairs(lua_State *L)
+{
+    lua_pushcfunction(L, readonly_next);
+    lua_pushvalue(L, 1);
+    lua_pushnil(L);
+
+    return 3;
+}
+
+void ecs_lua_readonly(lua_State *L)
+{
+    /* Nested tables first, their fields are replaced with proxies */
+    lua_pushnil(L);
+
+    while(lua_next(L, -2))
+    {
+        if(lua_type(L, -1) == LUA_TTABLE)
+        {
+            ecs_lua_readonly(L);
+            lua_pushvalue(L, -2);
+            lua_insert(L, -2);
+            lua_rawset(L, -4);
+        }
+        else lua_pop(L, 1);
+    }
+
+    lua_createtable(L, 0, 1);
+    lua_insert(L, -2);
+    lua_rawsetp(L, -2, &readonly_key);
+
+    luaL_setmetatable(L, "ecs_readonly");
+}
+
 int zero_init_component(lua_State *L)
 {
     ecs_world_t *w = ecs_lua_world(L);
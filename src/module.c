@@ -78,10 +78,15 @@ int new_module(lua_State *L)
 
     void *orig = ecs_get_context(w);
 
+    ecs_time_t span_start;
+    bool trace = ecs_lua_trace_begin(L, &span_start);
+
     ecs_set_context(w, &m);
     ecs_entity_t e = ecs_import(w, import_entry_point, module_name);
     ecs_set_context(w, orig);
 
+    if(trace) ecs_lua_trace_end(L, &span_start, "module", module_name);
+
     ecs_os_free(module_name);
 
     if(ctx->error) return lua_error(L);
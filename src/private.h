@@ -29,6 +29,12 @@
 
 //Compat stuff end
 
+#if defined(_MSC_VER)
+    #define ECS_LUA_TLS __declspec(thread)
+#else
+    #define ECS_LUA_TLS __thread
+#endif
+
 extern ECS_COMPONENT_DECLARE(EcsLuaHost);
 
 #define ECS_LUA_CONTEXT    (1)
@@ -37,6 +43,17 @@ extern ECS_COMPONENT_DECLARE(EcsLuaHost);
 #define ECS_LUA_COLLECT    (4)
 #define ECS_LUA_REGISTRY   (5)
 #define ECS_LUA_APIWORLD   (6)
+#define ECS_LUA_FILTERS    (7)
+#define ECS_LUA_LOOKUP     (8)
+#define ECS_LUA_SYSTEMS    (9)
+#define ECS_LUA_TIMERS     (10)
+#define ECS_LUA_COLUMNS    (11)
+
+/* Compiled filters cached by expression per world */
+#define ECS_LUA_FILTER_CACHE_MAX (256)
+
+/* Lookup results cached by name per world */
+#define ECS_LUA_LOOKUP_CACHE_MAX (256)
 
 /* For internal API functions */
 static inline ecs_world_t *ecs_lua_world_internal(lua_State *L)
@@ -113,13 +130,52 @@ int ecs_lua_rawgeti(lua_State *L, ecs_world_t *world, int ref);
 /* Releases the reference ref from the registry for the given world  */
 void ecs_lua_unref(lua_State *L, ecs_world_t *world, int ref);
 
+/* Returns the world pointer used by API functions, callbacks swap it with the stage */
+ecs_world_t **world_buf(lua_State *L, const ecs_world_t *world);
+
+/* profiler */
+
+/* Name of the Lua system or observer being called, root frame of profiler samples */
+extern ECS_LUA_TLS const char *ecs_lua_running_system;
+
+/* trace */
+
+/* Returns true and the current time if tracing is enabled for the state */
+bool ecs_lua_trace_begin(lua_State *L, ecs_time_t *start);
+
+/* Records a span from start to now if tracing is still enabled, name is copied */
+void ecs_lua_trace_end(lua_State *L, const ecs_time_t *start, const char *cat, const char *name);
+
 /* meta */
-bool ecs_lua_query_next(lua_State *L, int idx);
+bool ecs_lua_iter_next(lua_State *L, int idx);
 int meta_constants(lua_State *L);
 
+/* Resolves a dot-separated member path of type, returns 0 on success */
+int ecs_lua_member(const ecs_world_t *world, ecs_entity_t type, const char *path, ecs_entity_t *member_type, int32_t *offset);
+
 /* Update iterator, usually called after ecs_lua_to_iter() + ecs_*_next() */
 void ecs_lua_iter_update(lua_State *L, int idx, ecs_iter_t *it);
 
+/* timer */
+
+/* Creates the system that runs ecs.after() and ecs.every() timers, called on import */
+void ecs_lua_timer_init(ecs_world_t *world);
+
+/* shard */
+
+/* Creates the lock of the shard pool, called on import */
+void ecs_lua_shard_init(void);
+
+/* channel */
+
+/* Creates the lock of the channel registry, called on import */
+void ecs_lua_channel_init(void);
+
+/* entity */
+
+/* Invalidates the lookup caches of the world, called by observers */
+void ecs_lua_lookup_invalidate(const ecs_world_t *world);
+
 /* iter */
 ecs_iter_t *ecs_lua__checkiter(lua_State *L, int idx);
 ecs_term_t checkterm(lua_State *L, const ecs_world_t *world, int arg);
@@ -127,9 +183,24 @@ ecs_term_t checkterm(lua_State *L, const ecs_world_t *world, int arg);
 /* misc */
 ecs_type_t checktype(lua_State *L, int arg);
 int check_filter_desc(lua_State *L, const ecs_world_t *world, ecs_filter_desc_t *desc, int arg);
-ecs_filter_t *checkfilter(lua_State *L, const ecs_world_t *world, int arg);
+/* Returns the compiled filter for the filter object, descriptor or expression
+   at arg and pushes the filter object, compiled filters are cached */
+ecs_filter_t *checkfilter(lua_State *L, ecs_world_t *world, int arg);
 ecs_query_t *checkquery(lua_State *L, int arg);
+ecs_lua_query_t *ecs_lua__checkquery(lua_State *L, int arg);
+
+/* ecs_query_next(), optionally skipping tables that did not change */
+bool ecs_lua_query_next(ecs_iter_t *it, bool changed_only);
+
+/* ecs_query_iter() with the context for order_by callbacks */
+ecs_iter_t ecs_lua_query_iter(lua_State *L, ecs_world_t *world, const ecs_lua_query_t *q);
 int ecs_lua__readonly(lua_State *L);
+int ecs_lua__readonly_index(lua_State *L);
+int ecs_lua__readonly_len(lua_State *L);
+int ecs_lua__readonly_pairs(lua_State *L);
+
+/* Replaces the table at the top of the stack with a read-only proxy, nested tables included */
+void ecs_lua_readonly(lua_State *L);
 void ecs_lua__assert(lua_State *L, bool condition, const char *param, const char *condition_str);
 
 #ifdef NDEBUG
@@ -148,6 +219,11 @@ typedef struct ecs_lua_ctx
     int error;
     int progress_ref;
     int prefix_ref;
+
+    ecs_lua_cache_stats_t cache_stats;
+
+    /* Lookup cache generation, see ecs_lua_lookup_invalidate() */
+    int32_t lookup_generation;
 }ecs_lua_ctx;
 
 typedef enum EcsLuaCallbackType
@@ -163,8 +239,41 @@ typedef struct ecs_lua_callback
 
     EcsLuaCallbackType type;
     const char *type_name;
+
+    /* Share read-only column tables with other systems in the same frame */
+    bool cache_columns;
+
+    /* Don't call the function for tables that did not change since the last run */
+    bool changed_only;
+
+    /* Called once per run with the query iterator, see ecs.iter_next() */
+    bool run;
+
+    /* Accumulated pcall() time, exported by ecs_lua_export_stats() */
+    ecs_entity_t entity;
+    double time_total;
+    int64_t calls;
 }ecs_lua_callback;
 
+typedef struct ecs_lua_each_t ecs_lua_each_t;
+
+/* Userdata of "ecs_query_t" objects */
+typedef struct ecs_lua_query_t
+{
+    ecs_query_t *query;
+
+    /* ecs.each() state owned by the query */
+    ecs_lua_each_t *each;
+    int each_ref;
+
+    /* order_by = { component, member|function } */
+    ecs_entity_t order_by;
+    int32_t order_by_offset;
+    int order_by_ref;
+
+    ecs_entity_t group_by;
+}ecs_lua_query_t;
+
 typedef struct EcsLuaIter
 {
     int ptr_only;
@@ -0,0 +1,248 @@
+#include "private.h"
+
+#include <stdio.h>
+
+#define ECS_LUA_PROFILER_DEPTH (64)
+#define ECS_LUA_PROFILER_STACK (4096)
+
+ECS_LUA_TLS const char *ecs_lua_running_system;
+
+static const char profiler_key = 'p';
+
+/* Folded stacks with the same hash are chained */
+typedef struct ecs_lua_profiler_stack_t
+{
+    struct ecs_lua_profiler_stack_t *next;
+    int64_t count;
+    char folded[];
+}ecs_lua_profiler_stack_t;
+
+/* Userdata of "ecs_profiler_t" objects, registry[&profiler_key] while running */
+typedef struct ecs_lua_profiler_t
+{
+    ecs_map_t stacks; /* hash -> ecs_lua_profiler_stack_t* */
+    int64_t samples;
+
+    double interval;
+    ecs_time_t last;
+
+    /* Hook active before the profiler started */
+    lua_Hook prev_hook;
+    int prev_mask;
+    int prev_count;
+
+    char buf[ECS_LUA_PROFILER_STACK];
+}ecs_lua_profiler_t;
+
+static uint64_t stack_hash(const char *str)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    const unsigned char *p = (const unsigned char*)str;
+
+    for(; *p; p++) hash = (hash ^ *p) * 1099511628211ULL;
+
+    return hash;
+}
+
+static void profiler_clear(ecs_lua_profiler_t *p)
+{
+    ecs_map_iter_t it = ecs_map_iter(&p->stacks);
+
+    while(ecs_map_next(&it))
+    {
+        ecs_lua_profiler_stack_t *stack = ecs_map_ptr(&it), *next;
+
+        for(; stack; stack = next)
+        {
+            next = stack->next;
+            ecs_os_free(stack);
+        }
+    }
+
+    ecs_map_fini(&p->stacks);
+}
+
+int profiler_gc(lua_State *L)
+{
+    ecs_lua_profiler_t *p = luaL_checkudata(L, 1, "ecs_profiler_t");
+
+    profiler_clear(p);
+
+    return 0;
+}
+
+/* Appends a frame, ';' separates frames in the folded format */
+static size_t append_frame(char *buf, size_t len, const lua_Debug *ar)
+{
+    size_t size = ECS_LUA_PROFILER_STACK - len;
+    int n;
+
+    if(*ar->what == 'C') n = snprintf(buf + len, size, ";%s", ar->name ? ar->name : "?");
+    else if(ar->name) n = snprintf(buf + len, size, ";%s@%s:%d", ar->name, ar->short_src, ar->linedefined);
+    else n = snprintf(buf + len, size, ";%s:%d", ar->short_src, ar->linedefined);
+
+    if(n < 0 || (size_t)n >= size) return len;
+
+    char *c;
+    for(c = buf + len + 1; *c; c++) if(*c == ';' || *c == '\n') *c = ':';
+
+    return len + n;
+}
+
+static void record_sample(lua_State *L, ecs_lua_profiler_t *p)
+{
+    lua_Debug ar[ECS_LUA_PROFILER_DEPTH];
+    int i, depth = 0;
+
+    while(depth < ECS_LUA_PROFILER_DEPTH && lua_getstack(L, depth, &ar[depth]))
+    {
+        lua_getinfo(L, "Sn", &ar[depth]);
+        depth++;
+    }
+
+    /* Root frame is the running system, frames are outermost first */
+    const char *root = ecs_lua_running_system ? ecs_lua_running_system : "lua";
+    size_t len = snprintf(p->buf, ECS_LUA_PROFILER_STACK, "%s", root);
+
+    if(len >= ECS_LUA_PROFILER_STACK) len = ECS_LUA_PROFILER_STACK - 1;
+
+    for(i=depth - 1; i >= 0; i--) len = append_frame(p->buf, len, &ar[i]);
+
+    uint64_t hash = stack_hash(p->buf);
+    ecs_map_val_t *val = ecs_map_ensure(&p->stacks, hash);
+    ecs_lua_profiler_stack_t *stack = (ecs_lua_profiler_stack_t*)(uintptr_t)*val;
+
+    for(; stack; stack = stack->next) if(!strcmp(stack->folded, p->buf)) break;
+
+    if(!stack)
+    {
+        stack = ecs_os_malloc(ECS_SIZEOF(ecs_lua_profiler_stack_t) + (ecs_size_t)len + 1);
+        memcpy(stack->folded, p->buf, len + 1);
+        stack->count = 0;
+        stack->next = (ecs_lua_profiler_stack_t*)(uintptr_t)*val;
+        *val = (ecs_map_val_t)(uintptr_t)stack;
+    }
+
+    stack->count++;
+    p->samples++;
+}
+
+static void profiler_hook(lua_State *L, lua_Debug *ar)
+{
+    if(lua_rawgetp(L, LUA_REGISTRYINDEX, &profiler_key) != LUA_TUSERDATA)
+    {
+        lua_pop(L, 1);
+        return;
+    }
+
+    ecs_lua_profiler_t *p = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+
+    /* The count hook only polls the clock, samples are taken at the interval */
+    ecs_time_t now = p->last;
+
+    if(ecs_time_measure(&now) < p->interval) return;
+
+    ecs_os_get_time(&p->last);
+
+    record_sample(L, p);
+}
+
+int profiler_start(lua_State *L)
+{
+    lua_Integer interval_us = 1000, count = 1000;
+
+    if(!lua_isnoneornil(L, 1))
+    {
+        luaL_checktype(L, 1, LUA_TTABLE);
+
+        if(lua_getfield(L, 1, "interval_us") != LUA_TNIL) interval_us = luaL_checkinteger(L, -1);
+        if(lua_getfield(L, 1, "count") != LUA_TNIL) count = luaL_checkinteger(L, -1);
+
+        lua_pop(L, 2);
+    }
+
+    if(interval_us < 0) return luaL_argerror(L, 1, "interval_us must be >= 0");
+    if(count < 1 || count > INT32_MAX) return luaL_argerror(L, 1, "count out of range");
+
+    if(lua_rawgetp(L, LUA_REGISTRYINDEX, &profiler_key) != LUA_TNIL)
+        return luaL_error(L, "profiler is already running");
+
+    lua_pop(L, 1);
+
+    ecs_lua_profiler_t *p = lua_newuserdata(L, sizeof(ecs_lua_profiler_t));
+
+    ecs_map_init(&p->stacks, NULL);
+    p->samples = 0;
+    p->interval = interval_us / 1000000.0;
+    ecs_os_get_time(&p->last);
+
+    p->prev_hook = lua_gethook(L);
+    p->prev_mask = lua_gethookmask(L);
+    p->prev_count = lua_gethookcount(L);
+
+    luaL_setmetatable(L, "ecs_profiler_t");
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &profiler_key);
+
+    lua_sethook(L, profiler_hook, LUA_MASKCOUNT, (int)count);
+
+    return 0;
+}
+
+int profiler_stop(lua_State *L)
+{
+    const char *path = luaL_optstring(L, 1, NULL);
+
+    if(lua_rawgetp(L, LUA_REGISTRYINDEX, &profiler_key) != LUA_TUSERDATA)
+        return luaL_error(L, "profiler is not running");
+
+    ecs_lua_profiler_t *p = lua_touserdata(L, -1);
+
+    lua_sethook(L, p->prev_hook, p->prev_mask, p->prev_count);
+
+    lua_pushnil(L);
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &profiler_key);
+
+    /* "root;frame;frame count" lines as expected by flamegraph.pl */
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    ecs_map_iter_t it = ecs_map_iter(&p->stacks);
+
+    while(ecs_map_next(&it))
+    {
+        ecs_lua_profiler_stack_t *stack = ecs_map_ptr(&it);
+
+        for(; stack; stack = stack->next)
+            ecs_strbuf_append(&buf, "%s %lld\n", stack->folded, (long long)stack->count);
+    }
+
+    lua_Integer samples = p->samples;
+    char *folded = ecs_strbuf_get(&buf);
+
+    profiler_clear(p);
+    ecs_map_init(&p->stacks, NULL); /* __gc still runs */
+
+    if(!path)
+    {
+        lua_pushstring(L, folded ? folded : "");
+        ecs_os_free(folded);
+        return 1;
+    }
+
+    FILE *f = fopen(path, "wb");
+    int err = 1;
+
+    if(f)
+    {
+        size_t len = folded ? strlen(folded) : 0;
+        err = fwrite(folded, 1, len, f) != len;
+        err |= fclose(f);
+    }
+
+    ecs_os_free(folded);
+
+    if(err) return luaL_error(L, "failed to write %s", path);
+
+    lua_pushinteger(L, samples);
+
+    return 1;
+}
@@ -1,101 +1,404 @@
 #include "private.h"
 
-ecs_query_t *checkquery(lua_State *L, int arg)
+typedef struct ecs_lua_sort_ctx_t
+{
+    lua_State *L;
+    ecs_world_t *world;
+    const ecs_lua_query_t *query;
+}ecs_lua_sort_ctx_t;
+
+/* ecs_order_by_action_t has no context parameter, flecs sorts
+   synchronously in ecs_query_init() and ecs_query_iter() which are
+   always wrapped by init_query() and ecs_lua_query_iter() */
+static ECS_LUA_TLS ecs_lua_sort_ctx_t *sort_ctx;
+
+static int compare_entity(ecs_entity_t e1, ecs_entity_t e2)
+{
+    return (e1 > e2) - (e1 < e2);
+}
+
+#define ECS_LUA_MEMBER_COMPARE(name, T) \
+    static int compare_##name(ecs_entity_t e1, const void *p1, ecs_entity_t e2, const void *p2) \
+    { \
+        ecs_assert(sort_ctx != NULL, ECS_INTERNAL_ERROR, NULL); \
+        int32_t offset = sort_ctx->query->order_by_offset; \
+        T v1 = *(const T*)ECS_OFFSET(p1, offset); \
+        T v2 = *(const T*)ECS_OFFSET(p2, offset); \
+        return (v1 > v2) - (v1 < v2); \
+    }
+
+ECS_LUA_MEMBER_COMPARE(u8, uint8_t)
+ECS_LUA_MEMBER_COMPARE(u16, uint16_t)
+ECS_LUA_MEMBER_COMPARE(u32, uint32_t)
+ECS_LUA_MEMBER_COMPARE(u64, uint64_t)
+ECS_LUA_MEMBER_COMPARE(i8, int8_t)
+ECS_LUA_MEMBER_COMPARE(i16, int16_t)
+ECS_LUA_MEMBER_COMPARE(i32, int32_t)
+ECS_LUA_MEMBER_COMPARE(i64, int64_t)
+ECS_LUA_MEMBER_COMPARE(f32, float)
+ECS_LUA_MEMBER_COMPARE(f64, double)
+ECS_LUA_MEMBER_COMPARE(uptr, uintptr_t)
+ECS_LUA_MEMBER_COMPARE(iptr, intptr_t)
+ECS_LUA_MEMBER_COMPARE(char, char)
+
+static int compare_string(ecs_entity_t e1, const void *p1, ecs_entity_t e2, const void *p2)
 {
-    ecs_query_t **query = luaL_checkudata(L, arg, "ecs_query_t");
+    ecs_assert(sort_ctx != NULL, ECS_INTERNAL_ERROR, NULL);
 
-    if(!*query) luaL_argerror(L, arg, "query was collected");
+    int32_t offset = sort_ctx->query->order_by_offset;
+    const char *s1 = *(char* const*)ECS_OFFSET(p1, offset);
+    const char *s2 = *(char* const*)ECS_OFFSET(p2, offset);
 
-    if(ecs_query_orphaned(*query)) luaL_argerror(L, arg, "parent query was collected");
+    if(!s1 || !s2) return (s1 != NULL) - (s2 != NULL);
 
-    return *query;
+    return strcmp(s1, s2);
 }
 
-int query_gc(lua_State *L)
+/* Calls order_by[2](e1, c1, e2, c2) */
+static int compare_lua(ecs_entity_t e1, const void *p1, ecs_entity_t e2, const void *p2)
 {
-    ecs_query_t **ptr = luaL_checkudata(L, 1, "ecs_query_t");
-    ecs_query_t *query = *ptr;
+    ecs_assert(sort_ctx != NULL, ECS_INTERNAL_ERROR, NULL);
 
-    if(query) ecs_query_fini(query);
+    lua_State *L = sort_ctx->L;
+    ecs_world_t *w = sort_ctx->world;
+    const ecs_lua_query_t *q = sort_ctx->query;
 
-    *ptr = NULL;
+    ecs_lua__prolog(L);
 
-    return 0;
+    ecs_lua_rawgeti(L, w, q->order_by_ref);
+
+    lua_pushinteger(L, e1);
+    ecs_ptr_to_lua(w, L, q->order_by, p1);
+    lua_pushinteger(L, e2);
+    ecs_ptr_to_lua(w, L, q->order_by, p2);
+
+    int ret = lua_pcall(L, 4, 1, 0);
+    int result;
+
+    if(ret)
+    {
+        ecs_os_err("order_by callback error (%d): %s", ret, lua_tostring(L, -1));
+        result = compare_entity(e1, e2);
+    }
+    else
+    {
+        lua_Number n = lua_tonumber(L, -1);
+        result = (n > 0) - (n < 0);
+    }
+
+    lua_pop(L, 1);
+
+    ecs_lua__epilog(L);
+
+    return result;
 }
 
-int query_new(lua_State *L)
+static ecs_order_by_action_t member_compare(ecs_primitive_kind_t kind)
 {
-    ecs_world_t *w = ecs_lua_world(L);
+    switch(kind)
+    {
+        case EcsBool:
+        case EcsByte:
+        case EcsU8: return compare_u8;
+        case EcsChar: return compare_char;
+        case EcsU16: return compare_u16;
+        case EcsU32: return compare_u32;
+        case EcsU64:
+        case EcsEntity: return compare_u64;
+        case EcsI8: return compare_i8;
+        case EcsI16: return compare_i16;
+        case EcsI32: return compare_i32;
+        case EcsI64: return compare_i64;
+        case EcsF32: return compare_f32;
+        case EcsF64: return compare_f64;
+        case EcsUPtr: return compare_uptr;
+        case EcsIPtr: return compare_iptr;
+        case EcsString: return compare_string;
+        default: return NULL;
+    }
+}
 
-    const char *sig = luaL_optstring(L, 1, NULL);
+/* Resolve a (dot-separated) member to its offset and comparator */
+static ecs_order_by_action_t check_member(lua_State *L, ecs_world_t *w, ecs_entity_t component, const char *path, int32_t *offset, int arg)
+{
+    if(!ecs_get(w, component, EcsMetaTypeSerialized)) luaL_argerror(L, arg, "component has no reflection data (order_by)");
+
+    ecs_entity_t type;
 
-    ecs_query_desc_t desc = { .filter.expr = sig };
+    if(ecs_lua_member(w, component, path, &type, offset)) luaL_error(L, "invalid member '%s' (order_by)", path);
 
-    if(sig == NULL) check_filter_desc(L, w, &desc.filter, 1);
+    ecs_primitive_kind_t kind;
 
-    ecs_query_t *query = ecs_query_init(w, &desc);
+    const EcsPrimitive *p = ecs_get(w, type, EcsPrimitive);
 
-    if(!query)
+    if(p) kind = p->kind;
+    else if(ecs_has(w, type, EcsEnum)) kind = EcsI32;
+    else if(ecs_has(w, type, EcsBitmask)) kind = EcsU32;
+    else
     {
-        lua_pushnil(L);
-        return 1;
+        luaL_error(L, "member '%s' is not a primitive type (order_by)", path);
+        return NULL;
+    }
+
+    return member_compare(kind);
+}
+
+/* order_by = { component, "member" | function(e1, c1, e2, c2) } */
+static void check_order_by(lua_State *L, ecs_world_t *w, ecs_lua_query_t *q, ecs_query_desc_t *desc, int arg)
+{
+    if(lua_getfield(L, arg, "order_by") == LUA_TNIL)
+    {
+        lua_pop(L, 1);
+        return;
+    }
+
+    if(!lua_istable(L, -1)) luaL_argerror(L, arg, "expected { component, member|function } (order_by)");
+
+    lua_rawgeti(L, -1, 1);
+    ecs_entity_t component = luaL_checkinteger(L, -1);
+
+    if(!ecs_is_valid(w, component) || !ecs_has(w, component, EcsComponent))
+        luaL_argerror(L, arg, "invalid component (order_by)");
+
+    int type = lua_rawgeti(L, -2, 2);
+
+    if(type == LUA_TSTRING)
+    {
+        desc->order_by = check_member(L, w, component, lua_tostring(L, -1), &q->order_by_offset, arg);
+
+        if(!desc->order_by) luaL_argerror(L, arg, "unsupported member type (order_by)");
+    }
+    else if(type == LUA_TFUNCTION)
+    {
+        lua_pushvalue(L, -1);
+        q->order_by_ref = ecs_lua_ref(L, w);
+        desc->order_by = compare_lua;
+    }
+    else luaL_argerror(L, arg, "expected member name or function (order_by)");
+
+    lua_pop(L, 3);
+
+    desc->order_by_component = component;
+    q->order_by = component;
+}
+
+/* group_by = Relationship, tables are grouped by the relationship target */
+static void check_group_by(lua_State *L, ecs_world_t *w, ecs_lua_query_t *q, ecs_query_desc_t *desc, int arg)
+{
+    if(lua_getfield(L, arg, "group_by") != LUA_TNIL)
+    {
+        ecs_entity_t rel = luaL_checkinteger(L, -1);
+
+        if(!ecs_is_valid(w, rel)) luaL_argerror(L, arg, "invalid entity (group_by)");
+
+        desc->group_by_id = rel;
+        q->group_by = rel;
+    }
+
+    lua_pop(L, 1);
+}
+
+ecs_lua_query_t *ecs_lua__checkquery(lua_State *L, int arg)
+{
+    ecs_lua_query_t *query = luaL_checkudata(L, arg, "ecs_query_t");
+
+    if(!query->query) luaL_argerror(L, arg, "query was collected");
+
+    if(ecs_query_orphaned(query->query)) luaL_argerror(L, arg, "parent query was collected");
+
+    return query;
+}
+
+ecs_query_t *checkquery(lua_State *L, int arg)
+{
+    return ecs_lua__checkquery(L, arg)->query;
+}
+
+ecs_iter_t ecs_lua_query_iter(lua_State *L, ecs_world_t *world, const ecs_lua_query_t *q)
+{
+    if(!q->order_by) return ecs_query_iter(world, q->query);
+
+    ecs_lua_sort_ctx_t ctx = { .L = L, .world = world, .query = q };
+    ecs_lua_sort_ctx_t *prev = sort_ctx;
+
+    sort_ctx = &ctx;
+    ecs_iter_t it = ecs_query_iter(world, q->query);
+    sort_ctx = prev;
+
+    return it;
+}
+
+bool ecs_lua_query_next(ecs_iter_t *it, bool changed_only)
+{
+    while(ecs_query_next(it))
+    {
+        if(!changed_only || ecs_query_changed(it->priv.iter.query.query, it)) return true;
+
+        ecs_query_skip(it);
     }
 
-    ecs_query_t **ptr = lua_newuserdata(L, sizeof(ecs_query_t*));
-    *ptr = query;
+    return false;
+}
+
+int query_gc(lua_State *L)
+{
+    ecs_lua_query_t *ptr = luaL_checkudata(L, 1, "ecs_query_t");
+
+    if(!ptr->query) return 0;
+
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+
+    /* An active ecs.each() state is released by its __gc */
+    if(ptr->each) ecs_lua_unref(L, w, ptr->each_ref);
+
+    if(ptr->order_by_ref != LUA_NOREF) ecs_lua_unref(L, w, ptr->order_by_ref);
+
+    ecs_query_fini(ptr->query);
+
+    ptr->query = NULL;
+    ptr->each = NULL;
+
+    return 0;
+}
+
+/* Pushes a query object, the query is set by the caller */
+static ecs_lua_query_t *push_query(lua_State *L)
+{
+    ecs_lua_query_t *ptr = lua_newuserdata(L, sizeof(ecs_lua_query_t));
+
+    ptr->query = NULL;
+    ptr->each = NULL;
+    ptr->each_ref = LUA_NOREF;
+    ptr->order_by = 0;
+    ptr->order_by_offset = 0;
+    ptr->order_by_ref = LUA_NOREF;
+    ptr->group_by = 0;
 
     /* Associate world with the object for sanity checks */
     lua_pushvalue(L, lua_upvalueindex(1));
     lua_setuservalue(L, -2);
 
     luaL_setmetatable(L, "ecs_query_t");
+
+    return ptr;
+}
+
+static int init_query(lua_State *L, ecs_world_t *w, ecs_lua_query_t *q, ecs_query_desc_t *desc)
+{
+    ecs_lua_sort_ctx_t ctx = { .L = L, .world = w, .query = q };
+    ecs_lua_sort_ctx_t *prev = sort_ctx;
+
+    sort_ctx = &ctx;
+    q->query = ecs_query_init(w, desc);
+    sort_ctx = prev;
+
+    if(!q->query)
+    {
+        if(q->order_by_ref != LUA_NOREF) ecs_lua_unref(L, w, q->order_by_ref);
+        q->order_by_ref = LUA_NOREF;
+
+        lua_pushnil(L);
+        return 1;
+    }
+
     register_collectible(L, w, -1);
 
     return 1;
 }
 
-int subquery_new(lua_State *L)
+int query_new(lua_State *L)
 {
     ecs_world_t *w = ecs_lua_world(L);
 
-    ecs_query_t *parent = checkquery(L, 1);
-    const char *sig = luaL_optstring(L, 2, NULL);
+    ecs_lua_query_t *q = push_query(L);
 
-    ecs_query_desc_t desc =
+    ecs_query_desc_t desc = {0};
+
+    if(lua_type(L, 1) == LUA_TTABLE)
     {
-        .filter.expr = sig,
-        .parent = parent
-    };
+        check_filter_desc(L, w, &desc.filter, 1);
+        check_group_by(L, w, q, &desc, 1);
+        check_order_by(L, w, q, &desc, 1); /* last, may take a reference */
+    }
+    else desc.filter.expr = luaL_checkstring(L, 1);
 
-    if(sig == NULL) check_filter_desc(L, w, &desc.filter, 2);
+    return init_query(L, w, q, &desc);
+}
+
+int subquery_new(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    ecs_query_t *parent = checkquery(L, 1);
 
-    ecs_query_t *query = ecs_query_init(w, &desc);
+    ecs_lua_query_t *q = push_query(L);
 
-    ecs_query_t **ptr = lua_newuserdata(L, sizeof(ecs_query_t*));
-    *ptr = query;
+    ecs_query_desc_t desc = { .parent = parent };
 
-    return 1;
+    if(lua_type(L, 2) == LUA_TTABLE)
+    {
+        check_filter_desc(L, w, &desc.filter, 2);
+        check_group_by(L, w, q, &desc, 2);
+        check_order_by(L, w, q, &desc, 2); /* last, may take a reference */
+    }
+    else desc.filter.expr = luaL_checkstring(L, 2);
+
+    return init_query(L, w, q, &desc);
 }
 
 int query_iter(lua_State *L)
 {ecs_lua_dbg("QUERY_iter");
     ecs_world_t *w = ecs_lua_world(L);
-    ecs_query_t *query = checkquery(L, 1);
+    ecs_lua_query_t *query = ecs_lua__checkquery(L, 1);
 
     ecs_lua_check_world(L, w, 1);
 
-    ecs_iter_t it = ecs_query_iter(w, query);
+    ecs_entity_t group = 0;
+    bool changed_only = false;
+
+    if(!lua_isnoneornil(L, 2))
+    {
+        luaL_checktype(L, 2, LUA_TTABLE);
+
+        if(lua_getfield(L, 2, "group") != LUA_TNIL)
+        {
+            group = luaL_checkinteger(L, -1);
+
+            if(!query->group_by) luaL_argerror(L, 2, "query has no group_by (group)");
+        }
+
+        lua_getfield(L, 2, "changed");
+        changed_only = lua_toboolean(L, -1);
+
+        lua_pop(L, 2);
+    }
+
+    ecs_iter_t it = ecs_lua_query_iter(L, w, query);
+
+    if(group) ecs_query_set_group(&it, group);
 
     /* will push with no columns because it->count = 0 */
     ecs_iter_to_lua(&it, L, true);
 
+    if(changed_only)
+    {/* checked by query_next() */
+        lua_getmetatable(L, -1);
+        lua_pushboolean(L, 1);
+        lua_setfield(L, -2, "__ecs_changed");
+        lua_pop(L, 1);
+    }
+
     return 1;
 }
 
 int query_next(lua_State *L)
 {
     ecs_iter_t *it = ecs_lua_to_iter(L, 1);
-    int b = ecs_query_next(it);
+    bool changed_only = luaL_getmetafield(L, 1, "__ecs_changed") != LUA_TNIL;
+
+    if(changed_only) lua_pop(L, 1);
+
+    int b = ecs_lua_query_next(it, changed_only);
 
     if(b) ecs_lua_iter_update(L, 1, it);
 
@@ -0,0 +1,411 @@
+#include "private.h"
+
+/* Worlds with their own Lua state, progressed by a shared thread pool */
+
+typedef struct ecs_lua_shard_t
+{
+    ecs_world_t *world;
+    ecs_ftime_t delta_time; /* Frames are paced to it, 0 if measured */
+    double due; /* Pool time of the next frame */
+    int32_t id;
+
+    bool owned; /* Created by ecs.shard_start(), finalized on stop */
+    bool running;
+    bool busy; /* A worker is in ecs_progress() */
+    bool stop; /* Stopped from a shard frame, removed by the worker */
+
+    ecs_lua_shard_stats_t stats;
+}ecs_lua_shard_t;
+
+typedef struct ecs_lua_shard_pool_t
+{
+    ecs_os_mutex_t lock;
+    ecs_os_cond_t cond; /* Shard runnable, shard idle or quit */
+
+    ecs_os_thread_t *threads;
+    int32_t thread_count;
+
+    ecs_vec_t shards; /* ecs_lua_shard_t*, NULL for stopped shards */
+    int32_t next; /* Round robin */
+
+    ecs_time_t epoch;
+    double wake; /* Pool time a sleeping worker wakes up, 0 if none */
+    bool quit;
+}ecs_lua_shard_pool_t;
+
+static int32_t pool_threads = 4;
+static ecs_lua_shard_pool_t *pool;
+static ecs_os_mutex_t pool_lock; /* Guards pool creation */
+
+/* Shard being progressed by the worker thread */
+static ECS_LUA_TLS ecs_lua_shard_t *running_shard;
+
+void ecs_lua_shard_init(void)
+{
+    if(!pool_lock && ecs_os_has_threading()) pool_lock = ecs_os_mutex_new();
+}
+
+static ecs_lua_shard_t *shard_get(int32_t shard)
+{
+    if(shard < 1 || shard > ecs_vec_count(&pool->shards)) return NULL;
+
+    return *ecs_vec_get_t(&pool->shards, ecs_lua_shard_t*, shard - 1);
+}
+
+/* Seconds since the pool was created */
+static double pool_time(void)
+{
+    ecs_time_t t = pool->epoch;
+
+    return ecs_time_measure(&t);
+}
+
+/* Takes the next runnable shard that is due, round robin so shards share the
+   workers fairly. Sets due to the earliest frame of the shards that are not due */
+static ecs_lua_shard_t *take_shard(double now, double *due)
+{
+    int32_t i, count = ecs_vec_count(&pool->shards);
+
+    *due = 0;
+
+    for(i=0; i < count; i++)
+    {
+        int32_t index = (pool->next + i) % count;
+        ecs_lua_shard_t *s = *ecs_vec_get_t(&pool->shards, ecs_lua_shard_t*, index);
+
+        if(!s || !s->running || s->busy) continue;
+
+        if(s->due > now)
+        {
+            if(!*due || s->due < *due) *due = s->due;
+            continue;
+        }
+
+        pool->next = index + 1;
+        s->busy = true;
+
+        return s;
+    }
+
+    return NULL;
+}
+
+static void *shard_worker(void *arg)
+{
+    ecs_os_mutex_lock(pool->lock);
+
+    while(!pool->quit)
+    {
+        double due, now = pool_time();
+        ecs_lua_shard_t *s = take_shard(now, &due);
+
+        if(!s)
+        {
+            /* The OS API has no timed wait, an idle worker sleeps until the
+               next shard is due and wakes the others. Another one only sleeps
+               if a shard is due before that */
+            if(due && (!pool->wake || due < pool->wake))
+            {
+                pool->wake = due;
+                ecs_os_mutex_unlock(pool->lock);
+
+                ecs_sleepf(due - now);
+
+                ecs_os_mutex_lock(pool->lock);
+                if(pool->wake == due) pool->wake = 0;
+
+                ecs_os_cond_broadcast(pool->cond);
+            }
+            else ecs_os_cond_wait(pool->cond, pool->lock);
+
+            continue;
+        }
+
+        ecs_os_mutex_unlock(pool->lock);
+
+        ecs_time_t start;
+        ecs_os_get_time(&start);
+
+        running_shard = s;
+
+        bool running = ecs_progress(s->world, s->delta_time);
+
+        running_shard = NULL;
+
+        double t = ecs_time_measure(&start);
+
+        ecs_os_mutex_lock(pool->lock);
+
+        /* With a fixed delta_time ecs_progress() does not sleep, the shard is
+           not taken again until its next frame is due. A shard that fell
+           behind is not run back to back to catch up */
+        if(s->delta_time > 0)
+        {
+            s->due += s->delta_time;
+            if(s->due <= now) s->due = now + s->delta_time;
+        }
+
+        s->busy = false;
+        s->running = s->running && running;
+
+        s->stats.frames++;
+        s->stats.frame_time_total += t;
+        s->stats.frame_time_last = t;
+        if(t > s->stats.frame_time_max) s->stats.frame_time_max = t;
+
+        /* Wake ecs_lua_shard_stop() */
+        ecs_os_cond_broadcast(pool->cond);
+
+        if(s->stop)
+        {
+            *ecs_vec_get_t(&pool->shards, ecs_lua_shard_t*, s->id - 1) = NULL;
+
+            ecs_os_mutex_unlock(pool->lock);
+
+            if(s->owned) ecs_fini(s->world);
+            ecs_os_free(s);
+
+            ecs_os_mutex_lock(pool->lock);
+        }
+    }
+
+    ecs_os_mutex_unlock(pool->lock);
+
+    return NULL;
+}
+
+static int pool_init(void)
+{
+    if(!ecs_os_has_threading()) return -1;
+
+    ecs_assert(pool_lock != 0, ECS_INVALID_OPERATION, "FlecsLua is not imported");
+
+    ecs_os_mutex_lock(pool_lock);
+
+    if(pool)
+    {
+        ecs_os_mutex_unlock(pool_lock);
+        return 0;
+    }
+
+    pool = ecs_os_calloc(sizeof(ecs_lua_shard_pool_t));
+
+    ecs_os_get_time(&pool->epoch);
+
+    pool->lock = ecs_os_mutex_new();
+    pool->cond = ecs_os_cond_new();
+    ecs_vec_init_t(NULL, &pool->shards, ecs_lua_shard_t*, 0);
+
+    pool->thread_count = pool_threads;
+    pool->threads = ecs_os_malloc(pool->thread_count * ECS_SIZEOF(ecs_os_thread_t));
+
+    int32_t i;
+    for(i=0; i < pool->thread_count; i++) pool->threads[i] = ecs_os_thread_new(shard_worker, NULL);
+
+    ecs_os_mutex_unlock(pool_lock);
+
+    return 0;
+}
+
+void ecs_lua_shard_threads(int32_t count)
+{
+    ecs_assert(count > 0, ECS_INVALID_PARAMETER, NULL);
+    ecs_assert(pool == NULL, ECS_INVALID_OPERATION, "shard pool is already running");
+
+    pool_threads = count;
+}
+
+static int32_t shard_add(ecs_world_t *world, ecs_ftime_t delta_time, bool owned)
+{
+    if(pool_init()) return 0;
+
+    ecs_lua_shard_t *s = ecs_os_calloc(sizeof(ecs_lua_shard_t));
+
+    s->world = world;
+    s->delta_time = delta_time;
+    s->owned = owned;
+    s->running = true;
+
+    ecs_os_mutex_lock(pool->lock);
+
+    *ecs_vec_append_t(NULL, &pool->shards, ecs_lua_shard_t*) = s;
+    int32_t shard = s->id = ecs_vec_count(&pool->shards);
+
+    ecs_os_cond_broadcast(pool->cond);
+    ecs_os_mutex_unlock(pool->lock);
+
+    return shard;
+}
+
+int32_t ecs_lua_shard_start(ecs_world_t *world, ecs_ftime_t delta_time)
+{
+    ecs_assert(world != NULL, ECS_INVALID_PARAMETER, NULL);
+
+    return shard_add(world, delta_time, false);
+}
+
+/* Removes the shard after its current frame, returns the shard or NULL
+   if it is removed by the worker running the frame */
+static ecs_lua_shard_t *shard_remove(int32_t shard)
+{
+    if(!pool) return NULL;
+
+    ecs_os_mutex_lock(pool->lock);
+
+    ecs_lua_shard_t *s = shard_get(shard);
+
+    if(s)
+    {
+        s->running = false;
+
+        /* Waiting from a shard frame deadlocks if the shard stops itself
+           (or two shards stop each other), the worker removes it instead */
+        if(s->busy && running_shard)
+        {
+            s->stop = true;
+            s = NULL;
+        }
+        else
+        {
+            /* The shard may be removed by its worker while waiting */
+            while(shard_get(shard) == s && s->busy) ecs_os_cond_wait(pool->cond, pool->lock);
+
+            if(shard_get(shard) == s) *ecs_vec_get_t(&pool->shards, ecs_lua_shard_t*, shard - 1) = NULL;
+            else s = NULL;
+        }
+    }
+
+    ecs_os_mutex_unlock(pool->lock);
+
+    return s;
+}
+
+void ecs_lua_shard_stop(int32_t shard)
+{
+    ecs_lua_shard_t *s = shard_remove(shard);
+
+    if(!s) return;
+
+    if(s->owned) ecs_fini(s->world);
+
+    ecs_os_free(s);
+}
+
+bool ecs_lua_shard_stats(int32_t shard, ecs_lua_shard_stats_t *stats)
+{
+    ecs_assert(stats != NULL, ECS_INVALID_PARAMETER, NULL);
+
+    if(!pool) return false;
+
+    ecs_os_mutex_lock(pool->lock);
+
+    ecs_lua_shard_t *s = shard_get(shard);
+
+    if(s)
+    {
+        *stats = s->stats;
+        stats->running = s->running;
+    }
+
+    ecs_os_mutex_unlock(pool->lock);
+
+    return s != NULL;
+}
+
+void ecs_lua_shard_fini(void)
+{
+    if(!pool) return;
+
+    int32_t i, count = ecs_vec_count(&pool->shards);
+
+    for(i=1; i <= count; i++) ecs_lua_shard_stop(i);
+
+    ecs_os_mutex_lock(pool->lock);
+    pool->quit = true;
+    ecs_os_cond_broadcast(pool->cond);
+    ecs_os_mutex_unlock(pool->lock);
+
+    for(i=0; i < pool->thread_count; i++) ecs_os_thread_join(pool->threads[i]);
+
+    ecs_vec_fini_t(NULL, &pool->shards, ecs_lua_shard_t*);
+    ecs_os_cond_free(pool->cond);
+    ecs_os_mutex_free(pool->lock);
+    ecs_os_free(pool->threads);
+    ecs_os_free(pool);
+
+    pool = NULL;
+}
+
+int shard_start(lua_State *L)
+{
+    const char *path = luaL_checkstring(L, 1);
+    lua_Number delta_time = luaL_optnumber(L, 2, 0);
+
+    if(!ecs_os_has_threading()) return luaL_error(L, "shards require threading support in the OS API");
+
+    /* The shard's world and VM are set up on this thread */
+    ecs_world_t *world = ecs_init();
+
+    ECS_IMPORT(world, FlecsLua);
+
+    lua_State *SL = ecs_lua_get_state(world);
+
+    luaL_openlibs(SL);
+
+    if(luaL_loadfile(SL, path) || lua_pcall(SL, 0, 0, 0))
+    {
+        lua_pushstring(L, lua_tostring(SL, -1));
+        ecs_fini(world);
+        return lua_error(L);
+    }
+
+    int32_t shard = shard_add(world, delta_time, true);
+
+    if(!shard)
+    {
+        ecs_fini(world);
+        return luaL_error(L, "failed to start shard");
+    }
+
+    lua_pushinteger(L, shard);
+
+    return 1;
+}
+
+int shard_stop(lua_State *L)
+{
+    lua_Integer shard = luaL_checkinteger(L, 1);
+
+    if(shard < 1 || shard > INT32_MAX) return luaL_argerror(L, 1, "invalid shard");
+
+    ecs_lua_shard_stop((int32_t)shard);
+
+    return 0;
+}
+
+int shard_stats(lua_State *L)
+{
+    lua_Integer shard = luaL_checkinteger(L, 1);
+    ecs_lua_shard_stats_t stats;
+
+    if(shard < 1 || shard > INT32_MAX || !ecs_lua_shard_stats((int32_t)shard, &stats)) return 0;
+
+    lua_createtable(L, 0, 5);
+
+    lua_pushinteger(L, stats.frames);
+    lua_setfield(L, -2, "frames");
+
+    lua_pushnumber(L, stats.frame_time_total);
+    lua_setfield(L, -2, "frame_time_total");
+
+    lua_pushnumber(L, stats.frame_time_last);
+    lua_setfield(L, -2, "frame_time_last");
+
+    lua_pushnumber(L, stats.frame_time_max);
+    lua_setfield(L, -2, "frame_time_max");
+
+    lua_pushboolean(L, stats.running);
+    lua_setfield(L, -2, "running");
+
+    return 1;
+}
@@ -8,7 +8,7 @@ static void print_time(ecs_time_t *time, const char *str)
 #endif
 }
 
-static ecs_world_t **world_buf(lua_State *L, const ecs_world_t *world)
+ecs_world_t **world_buf(lua_State *L, const ecs_world_t *world)
 {
     int ret = lua_rawgetp(L, LUA_REGISTRYINDEX, world);
     ecs_assert(ret == LUA_TTABLE, ECS_INTERNAL_ERROR, NULL);
@@ -24,6 +24,39 @@ static ecs_world_t **world_buf(lua_State *L, const ecs_world_t *world)
     return wbuf;
 }
 
+/* Calls the functions of a system group with the iterator on top of the stack,
+   pops the table and the iterator like lua_pcall() */
+static int call_group(lua_State *L)
+{
+    int i, ret = 0, len = lua_rawlen(L, -2);
+
+    for(i=1; i <= len && !ret; i++)
+    {
+        lua_rawgeti(L, -2, i);
+        lua_pushvalue(L, -2);
+        ret = lua_pcall(L, 1, 0, 0);
+    }
+
+    if(ret) lua_insert(L, -3); /* error message */
+
+    lua_pop(L, 2);
+
+    return ret;
+}
+
+/* Run systems iterate on their own, finishes the iterator if the function
+   returned before the query was exhausted. Expects the iterator on top */
+static void run_fini(lua_State *L, ecs_iter_t *it)
+{
+    if(ECS_BIT_IS_SET(it->flags, EcsIterIsValid))
+    {/* Stopped inside a table */
+        ecs_lua_to_iter(L, -1);
+        ecs_iter_fini(it);
+    }
+    else if(luaL_getmetafield(L, -1, "__ecs_done") == LUA_TNIL) ecs_iter_fini(it); /* never advanced */
+    else lua_pop(L, 1);
+}
+
 /* Used for systems, triggers and observers */
 static void ecs_lua__callback(ecs_iter_t *it)
 {
@@ -33,6 +66,15 @@ static void ecs_lua__callback(ecs_iter_t *it)
     ecs_lua_callback *cb = it->binding_ctx;
     const ecs_world_t *real_world = ecs_get_world(it->world);
 
+    /* Nothing to react to, don't mark the system's outputs as written.
+       Run systems skip tables in ecs.iter_next() */
+    if(cb->changed_only && !cb->run && it->table && it->next == ecs_query_next &&
+       !ecs_query_changed(ecs_system_get_query(w, it->system), it))
+    {
+        ecs_query_skip(it);
+        return;
+    }
+
     int stage_id = ecs_get_stage_id(w);
     int stage_count = ecs_get_stage_count(w);
     const char *name = ecs_get_name(it->world, it->system);
@@ -59,27 +101,62 @@ static void ecs_lua__callback(ecs_iter_t *it)
     ecs_world_t *prev_world = *wbuf;
     *wbuf = it->world;
 
-    ecs_time_t time;
+    ecs_time_t time, span_start, phase_start;
+    bool trace = ecs_lua_trace_begin(L, &span_start);
 
+    /* function or { function, ... } for system groups */
     int type = ecs_lua_rawgeti(L, w, cb->func_ref);
 
-    ecs_assert(type == LUA_TFUNCTION, ECS_INTERNAL_ERROR, NULL);
+    ecs_assert(type == LUA_TFUNCTION || type == LUA_TTABLE, ECS_INTERNAL_ERROR, NULL);
 
     ecs_os_get_time(&time);
+    phase_start = time;
 
     ecs_iter_to_lua(it, L, false);
 
+    if(cb->run && cb->changed_only)
+    {/* checked by ecs_lua_iter_next() */
+        lua_getmetatable(L, -1);
+        lua_pushboolean(L, 1);
+        lua_setfield(L, -2, "__ecs_changed");
+        lua_pop(L, 1);
+    }
+
+    if(cb->type == EcsLuaObserver && it->param)
+    {/* ecs.emit() payload */
+        const EcsComponent *ptr = ecs_get(real_world, it->event, EcsComponent);
+
+        if(ptr && ptr->size)
+        {
+            ecs_ptr_to_lua(real_world, L, it->event, it->param);
+            lua_setfield(L, -2, "payload");
+        }
+    }
+
+    if(trace) ecs_lua_trace_end(L, &phase_start, "lua", "iter serialization");
+
     print_time(&time, "iter serialization");
 
     lua_pushvalue(L, -1);
     int it_ref = luaL_ref(L, LUA_REGISTRYINDEX);
 
     ecs_os_get_time(&time);
+    phase_start = time;
 
-    int ret = lua_pcall(L, 1, 0, 0);
+    const char *prev_system = ecs_lua_running_system;
+    ecs_lua_running_system = name;
+
+    int ret = type == LUA_TTABLE ? call_group(L) : lua_pcall(L, 1, 0, 0);
 
+    ecs_lua_running_system = prev_system;
     *wbuf = prev_world;
 
+    ecs_time_t start = time;
+    cb->time_total += ecs_time_measure(&start);
+    cb->calls++;
+
+    if(trace) ecs_lua_trace_end(L, &phase_start, "lua", "pcall");
+
     print_time(&time, "system");
 
     if(ret)
@@ -96,17 +173,246 @@ static void ecs_lua__callback(ecs_iter_t *it)
     ecs_assert(lua_type(L, -1) == LUA_TTABLE, ECS_INTERNAL_ERROR, NULL);
 
     ecs_os_get_time(&time);
+    phase_start = time;
 
-    ecs_lua_to_iter(L, -1);
+    if(cb->run) run_fini(L, it);
+    else ecs_lua_to_iter(L, -1);
+
+    if(trace) ecs_lua_trace_end(L, &phase_start, "lua", "iter deserialization");
 
     print_time(&time, "iter deserialization");
 
     luaL_unref(L, LUA_REGISTRYINDEX, it_ref);
     lua_pop(L, 1);
 
+    if(trace) ecs_lua_trace_end(L, &span_start, cb->type_name, name ? name : "<anonymous>");
+
     ecs_lua__epilog(L);
 }
 
+typedef struct ecs_lua_batch_record_t
+{
+    ecs_entity_t entity;
+    ecs_entity_t event;
+    ecs_id_t id;
+}ecs_lua_batch_record_t;
+
+/* Consecutive records from the same table */
+typedef struct ecs_lua_batch_group_t
+{
+    ecs_table_t *table;
+    int32_t first;
+    int32_t count;
+}ecs_lua_batch_group_t;
+
+/* Shared by a batched observer and its flush system */
+typedef struct ecs_lua_batch_t
+{
+    int32_t refs;
+    ecs_vec_t records;
+    ecs_vec_t groups;
+}ecs_lua_batch_t;
+
+static void batch_release(void *ptr)
+{
+    ecs_lua_batch_t *batch = ptr;
+
+    if(--batch->refs) return;
+
+    ecs_vec_fini_t(NULL, &batch->records, ecs_lua_batch_record_t);
+    ecs_vec_fini_t(NULL, &batch->groups, ecs_lua_batch_group_t);
+    ecs_os_free(batch);
+}
+
+/* Observer callback of batched observers, queues the events */
+static void ecs_lua__batch(ecs_iter_t *it)
+{
+    ecs_lua_batch_t *batch = it->ctx;
+
+    if(!it->count) return;
+
+    ecs_lua_batch_group_t *group = NULL;
+    int32_t count = ecs_vec_count(&batch->records);
+
+    if(ecs_vec_count(&batch->groups)) group = ecs_vec_last_t(&batch->groups, ecs_lua_batch_group_t);
+
+    if(!group || group->table != it->table)
+    {
+        group = ecs_vec_append_t(NULL, &batch->groups, ecs_lua_batch_group_t);
+        group->table = it->table;
+        group->first = count;
+        group->count = 0;
+    }
+
+    group->count += it->count;
+
+    int i;
+    for(i=0; i < it->count; i++)
+    {
+        ecs_lua_batch_record_t *r = ecs_vec_append_t(NULL, &batch->records, ecs_lua_batch_record_t);
+
+        r->entity = it->entities[i];
+        r->event = it->event;
+        r->id = it->event_id;
+    }
+}
+
+static void push_batch(lua_State *L, ecs_lua_batch_t *batch)
+{
+    int32_t i, count = ecs_vec_count(&batch->records);
+    int32_t group_count = ecs_vec_count(&batch->groups);
+    ecs_lua_batch_record_t *records = ecs_vec_first_t(&batch->records, ecs_lua_batch_record_t);
+    ecs_lua_batch_group_t *groups = ecs_vec_first_t(&batch->groups, ecs_lua_batch_group_t);
+
+    lua_createtable(L, 0, 5);
+
+    lua_pushinteger(L, count);
+    lua_setfield(L, -2, "count");
+
+    lua_createtable(L, count, 0);
+    for(i=0; i < count; i++)
+    {
+        lua_pushinteger(L, records[i].entity);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_setfield(L, -2, "entities");
+
+    lua_createtable(L, count, 0);
+    for(i=0; i < count; i++)
+    {
+        lua_pushinteger(L, records[i].event);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_setfield(L, -2, "events");
+
+    lua_createtable(L, count, 0);
+    for(i=0; i < count; i++)
+    {
+        lua_pushinteger(L, records[i].id);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_setfield(L, -2, "ids");
+
+    lua_createtable(L, group_count, 0);
+    for(i=0; i < group_count; i++)
+    {
+        lua_createtable(L, 0, 2);
+
+        lua_pushinteger(L, groups[i].first + 1);
+        lua_setfield(L, -2, "first");
+
+        lua_pushinteger(L, groups[i].count);
+        lua_setfield(L, -2, "count");
+
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_setfield(L, -2, "groups");
+}
+
+/* System callback of batched observers, delivers the queued events */
+static void ecs_lua__flush(ecs_iter_t *it)
+{
+    ecs_lua_batch_t *batch = it->ctx;
+    ecs_lua_callback *cb = it->binding_ctx;
+
+    if(!ecs_vec_count(&batch->records)) return;
+
+    ecs_world_t *w = it->world;
+    const ecs_world_t *real_world = ecs_get_world(it->world);
+    const char *name = ecs_get_name(it->world, it->system);
+
+    const EcsLuaHost *host = ecs_singleton_get(w, EcsLuaHost);
+    ecs_assert(host != NULL, ECS_INVALID_PARAMETER, NULL);
+
+    lua_State *L = host->L;
+
+    ecs_lua__prolog(L);
+
+    ecs_world_t **wbuf = world_buf(L, real_world);
+
+    ecs_world_t *prev_world = *wbuf;
+    *wbuf = it->world;
+
+    int type = ecs_lua_rawgeti(L, w, cb->func_ref);
+
+    ecs_assert(type == LUA_TFUNCTION, ECS_INTERNAL_ERROR, NULL);
+
+    push_batch(L, batch);
+
+    /* Events emitted by the callback are delivered by the next flush */
+    ecs_vec_clear(&batch->records);
+    ecs_vec_clear(&batch->groups);
+
+    int ret = lua_pcall(L, 1, 0, 0);
+
+    *wbuf = prev_world;
+
+    if(ret)
+    {
+        const char *err = lua_tostring(L, lua_gettop(L));
+        ecs_os_err("error in %s callback \"%s\" (%d): %s", cb->type_name, name, ret, err);
+        lua_pop(L, 1);
+    }
+
+    ecs_lua__epilog(L);
+}
+
+/* Returns the flush phase for { batch = true|phase } */
+static ecs_entity_t check_batch(lua_State *L, int arg)
+{
+    if(lua_isnoneornil(L, arg)) return 0;
+
+    luaL_checktype(L, arg, LUA_TTABLE);
+
+    ecs_entity_t phase = 0;
+    int type = lua_getfield(L, arg, "batch");
+
+    if(type == LUA_TBOOLEAN) phase = lua_toboolean(L, -1) ? EcsPostFrame : 0;
+    else if(type == LUA_TNUMBER) phase = luaL_checkinteger(L, -1);
+    else if(type != LUA_TNIL) luaL_argerror(L, arg, "invalid batch phase");
+
+    lua_pop(L, 1);
+
+    return phase;
+}
+
+static ecs_entity_t new_flush_system(ecs_world_t *w, ecs_entity_t observer, ecs_entity_t phase,
+                                     ecs_lua_batch_t *batch, ecs_lua_callback *cb)
+{
+    ecs_entity_desc_t edesc = {0};
+    edesc.add[0] = ecs_dependson(phase);
+    edesc.add[1] = phase;
+    edesc.add[2] = ecs_pair(EcsChildOf, observer);
+
+    ecs_system_desc_t desc = {0};
+    desc.entity = ecs_entity_init(w, &edesc);
+    desc.callback = ecs_lua__flush;
+    desc.ctx = batch;
+    desc.ctx_free = batch_release;
+    desc.binding_ctx = cb;
+
+    return ecs_system_init(w, &desc);
+}
+
+/* { cache_columns = boolean, changed_only = boolean, run = boolean } */
+static void check_system_options(lua_State *L, ecs_lua_callback *cb, int arg)
+{
+    if(lua_isnoneornil(L, arg)) return;
+
+    luaL_checktype(L, arg, LUA_TTABLE);
+
+    lua_getfield(L, arg, "cache_columns");
+    cb->cache_columns = lua_toboolean(L, -1);
+
+    lua_getfield(L, arg, "changed_only");
+    cb->changed_only = lua_toboolean(L, -1);
+
+    lua_getfield(L, arg, "run");
+    cb->run = lua_toboolean(L, -1);
+
+    lua_pop(L, 3);
+}
+
 static int check_events(lua_State *L, ecs_world_t *w, ecs_entity_t *events, int arg)
 {
     ecs_entity_t event = 0;
@@ -152,17 +458,22 @@ static int new_callback(lua_State *L, ecs_world_t *w, enum EcsLuaCallbackType ty
     ecs_lua_ctx *ctx = ecs_lua_get_context(L, w);
 
     ecs_entity_t e = 0;
-    luaL_checktype(L, 1, LUA_TFUNCTION);
+    /* function, or a table of functions for system groups */
+    if(lua_type(L, 1) != LUA_TTABLE) luaL_checktype(L, 1, LUA_TFUNCTION);
     const char *name = luaL_optstring(L, 2, NULL);
     /* phase, event or event[] expected for arg 3 */
     const char *signature = lua_type(L, 4) == LUA_TSTRING ? luaL_checkstring(L, 4) : NULL;
 
     ecs_lua_callback *cb = lua_newuserdata(L, sizeof(ecs_lua_callback));
+    memset(cb, 0, sizeof(ecs_lua_callback));
 
     ecs_lua_ref(L, w);
 
     if(type == EcsLuaObserver)
     {
+        ecs_entity_t batch_phase = check_batch(L, 5);
+        ecs_lua_batch_t *batch = NULL;
+
         ecs_entity_desc_t edesc = { .name = name };
         e = ecs_entity_init(w, &edesc);
 
@@ -178,14 +489,39 @@ static int new_callback(lua_State *L, ecs_world_t *w, enum EcsLuaCallbackType ty
 
         check_events(L, w, desc.events, 3);
 
+        if(batch_phase)
+        {
+            batch = ecs_os_calloc(sizeof(ecs_lua_batch_t));
+            batch->refs = 1;
+
+            desc.callback = ecs_lua__batch;
+            desc.ctx = batch;
+            desc.ctx_free = batch_release;
+        }
+
         e = ecs_observer_init(w, &desc);
 
+        if(batch && !e) batch_release(batch);
+        else if(batch)
+        {
+            batch->refs++;
+
+            if(!new_flush_system(w, e, batch_phase, batch, cb))
+            {
+                batch_release(batch);
+                ecs_delete(w, e);
+                e = 0;
+            }
+        }
+
         cb->type_name = "observer";
     }
     else /* EcsLuaSystem */
     {
         ecs_entity_t phase = luaL_checkinteger(L, 3);
 
+        check_system_options(L, cb, 5);
+
         ecs_entity_desc_t edesc = {0};
         edesc.name = name;
         edesc.add[0] = phase ? ecs_dependson(phase) : 0;
@@ -198,6 +534,9 @@ static int new_callback(lua_State *L, ecs_world_t *w, enum EcsLuaCallbackType ty
         desc.callback = ecs_lua__callback;
         desc.binding_ctx = cb;
 
+        /* Called once with the unstarted query iterator */
+        if(cb->run) desc.run = ecs_lua__callback;
+
         if(signature == NULL && !lua_isnoneornil(L, 4)) check_filter_desc(L, w, &desc.query.filter, 4);
 
         e = ecs_system_init(w, &desc);
@@ -211,6 +550,16 @@ static int new_callback(lua_State *L, ecs_world_t *w, enum EcsLuaCallbackType ty
     cb->func_ref = ecs_lua_ref(L, w);
     cb->param_ref = LUA_NOREF;
     cb->type = type;
+    cb->entity = e;
+
+    if(type == EcsLuaSystem)
+    {/* world[systems] = { cb1, cb2, ... } for the stats exporter */
+        lua_rawgetp(L, LUA_REGISTRYINDEX, ecs_get_world(w));
+        lua_rawgeti(L, -1, ECS_LUA_SYSTEMS);
+        lua_pushlightuserdata(L, cb);
+        lua_rawseti(L, -2, lua_rawlen(L, -2) + 1);
+        lua_pop(L, 2);
+    }
 
     lua_pushinteger(L, e);
 
@@ -220,6 +569,37 @@ static int new_callback(lua_State *L, ecs_world_t *w, enum EcsLuaCallbackType ty
 int new_system(lua_State *L)
 {
     ecs_world_t *w = ecs_lua_world(L);
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    return new_callback(L, w, EcsLuaSystem);
+}
+
+int new_system_group(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    luaL_checkstring(L, 1);
+    luaL_checkinteger(L, 2);
+    luaL_checktype(L, 4, LUA_TTABLE);
+
+    int i, len = luaL_len(L, 4);
+
+    if(len < 1) return luaL_argerror(L, 4, "empty system group");
+
+    /* Copied so the group can't change after it is created */
+    lua_createtable(L, len, 0);
+
+    for(i=1; i <= len; i++)
+    {
+        if(lua_geti(L, 4, i) != LUA_TFUNCTION) return luaL_argerror(L, 4, "function expected");
+
+        lua_rawseti(L, -2, i);
+    }
+
+    /* (name, phase, signature, fns) -> (fns, name, phase, signature) */
+    lua_replace(L, 4);
+    lua_settop(L, 4);
+    lua_rotate(L, 1, 1);
+
     return new_callback(L, w, EcsLuaSystem);
 }
 
@@ -231,9 +611,194 @@ int new_trigger(lua_State *L)
 int new_observer(lua_State *L)
 {
     ecs_world_t *w = ecs_lua_world(L);
+    luaL_checktype(L, 1, LUA_TFUNCTION);
     return new_callback(L, w, EcsLuaObserver);
 }
 
+static void check_ids(lua_State *L, ecs_id_t *ids, int32_t *count, int arg)
+{
+    int type = lua_type(L, arg);
+
+    if(type == LUA_TNUMBER)
+    {
+        ids[0] = luaL_checkinteger(L, arg);
+        *count = 1;
+        return;
+    }
+    else if(type != LUA_TTABLE) luaL_argerror(L, arg, "invalid id type");
+
+    int i, len = luaL_len(L, arg);
+
+    if(len < 1 || len > FLECS_ID_DESC_MAX) luaL_argerror(L, arg, "invalid id count");
+
+    for(i=0; i < len; i++)
+    {
+        if(lua_rawgeti(L, arg, i + 1) != LUA_TNUMBER) luaL_argerror(L, arg, "invalid id");
+
+        ids[i] = lua_tointeger(L, -1);
+        lua_pop(L, 1);
+    }
+
+    *count = len;
+}
+
+static void emit_events(ecs_world_t *w, ecs_entity_t *events, ecs_event_desc_t *desc)
+{
+    int i;
+    for(i=0; i < FLECS_EVENT_DESC_MAX && events[i]; i++)
+    {
+        desc->event = events[i];
+        ecs_emit(w, desc);
+    }
+}
+
+/* Emits events for the entities in the array at arg,
+   consecutive rows of a table are emitted as one range */
+static void emit_entities(lua_State *L, ecs_world_t *w, ecs_entity_t *events, ecs_event_desc_t *desc, int arg)
+{
+    int i, len = luaL_len(L, arg);
+
+    desc->table = NULL;
+    desc->count = 0;
+
+    for(i=1; i <= len; i++)
+    {
+        lua_rawgeti(L, arg, i);
+        ecs_entity_t e = checkentity(L, w, -1);
+        lua_pop(L, 1);
+
+        ecs_record_t *r = ecs_record_find(w, e);
+
+        if(!r || !r->table) continue;
+
+        int32_t row = ECS_RECORD_TO_ROW(r->row);
+
+        if(desc->table == r->table && desc->offset + desc->count == row)
+        {
+            desc->count++;
+            continue;
+        }
+
+        if(desc->count) emit_events(w, events, desc);
+
+        desc->table = r->table;
+        desc->offset = row;
+        desc->count = 1;
+    }
+
+    if(desc->count) emit_events(w, events, desc);
+}
+
+/* decode_payload(world, type, ptr, value), run protected so the
+   payload can be finalized if the conversion fails */
+static int decode_payload(lua_State *L)
+{
+    ecs_world_t *w = lua_touserdata(L, 1);
+    ecs_entity_t type = lua_tointeger(L, 2);
+    void *ptr = lua_touserdata(L, 3);
+
+    ecs_lua_to_ptr(w, L, 4, type, ptr);
+
+    return 0;
+}
+
+int emit_event(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    ecs_entity_t events[FLECS_EVENT_DESC_MAX] = {0};
+    ecs_id_t ids[FLECS_ID_DESC_MAX];
+    ecs_type_t type = { .array = ids };
+
+    check_events(L, w, events, 1);
+    check_ids(L, ids, &type.count, 2);
+
+    ecs_event_desc_t desc = { .ids = &type };
+
+    /* Check the target before the payload is constructed */
+    ecs_entity_t target = 0;
+    ecs_iter_t *it = NULL;
+
+    if(lua_type(L, 3) == LUA_TNUMBER) target = checkentity(L, w, 3);
+    else if(luaL_getmetafield(L, 3, "__ecs_iter") != LUA_TNIL)
+    {/* it: the current table range of an iterator */
+        lua_pop(L, 1);
+
+        it = ecs_lua__checkiter(L, 3);
+
+        if(!it->table) return luaL_argerror(L, 3, "iterator has no table");
+    }
+    else
+    {
+        luaL_checktype(L, 3, LUA_TTABLE);
+
+        int i, len = luaL_len(L, 3);
+
+        for(i=1; i <= len; i++)
+        {
+            lua_rawgeti(L, 3, i);
+            checkentity(L, w, -1);
+            lua_pop(L, 1);
+        }
+    }
+
+    void *param = NULL;
+
+    if(!lua_isnoneornil(L, 4))
+    {
+        if(events[1]) return luaL_argerror(L, 4, "payload requires a single event");
+
+        /* Event ids were validated by check_events() */
+        const ecs_type_info_t *ti = ecs_get_type_info(w, events[0]);
+
+        if(!ti || !ti->size) return luaL_argerror(L, 4, "event is not a component");
+
+        param = lua_newuserdata(L, ti->size);
+        ecs_value_init(w, events[0], param);
+
+        lua_pushcfunction(L, decode_payload);
+        lua_pushlightuserdata(L, w);
+        lua_pushinteger(L, events[0]);
+        lua_pushlightuserdata(L, param);
+        lua_pushvalue(L, 4);
+
+        if(lua_pcall(L, 4, 0, 0))
+        {
+            ecs_value_fini(w, events[0], param);
+            return lua_error(L);
+        }
+
+        desc.param = param;
+    }
+
+    if(target)
+    {
+        ecs_record_t *r = ecs_record_find(w, target);
+
+        if(r && r->table)
+        {
+            desc.table = r->table;
+            desc.offset = ECS_RECORD_TO_ROW(r->row);
+            desc.count = 1;
+
+            emit_events(w, events, &desc);
+        }
+    }
+    else if(it)
+    {
+        desc.table = it->table;
+        desc.offset = it->offset;
+        desc.count = it->count;
+
+        emit_events(w, events, &desc);
+    }
+    else emit_entities(L, w, events, &desc, 3);
+
+    if(param) ecs_value_fini(w, events[0], param);
+
+    return 0;
+}
+
 int run_system(lua_State *L)
 {
     ecs_world_t *w = ecs_lua_world(L);
@@ -1,5 +1,6 @@
 #include "private.h"
 
+#include <math.h>
 
 int set_timeout(lua_State *L)
 {
@@ -102,4 +103,440 @@ int set_tick_source(lua_State *L)
     ecs_set_tick_source(w, system, source);
 
     return 0;
-}
\ No newline at end of file
+}
+
+/* Hierarchical timer wheel for ecs.after() and ecs.every() */
+
+#define ECS_LUA_WHEEL_BITS   (6)
+#define ECS_LUA_WHEEL_SLOTS  (1 << ECS_LUA_WHEEL_BITS)
+#define ECS_LUA_WHEEL_MASK   (ECS_LUA_WHEEL_SLOTS - 1)
+#define ECS_LUA_WHEEL_LEVELS (4)
+#define ECS_LUA_WHEEL_HZ     (1000) /* ticks per second */
+
+typedef struct ecs_lua_wheel_timer_t
+{
+    uint64_t expires; /* tick */
+    uint64_t interval; /* ticks, 0 for ecs.after() */
+    int func_ref;
+    uint32_t generation;
+
+    /* Slot list, or the free list */
+    int32_t prev, next;
+    int32_t *head; /* NULL if not scheduled */
+}ecs_lua_wheel_timer_t;
+
+/* Userdata of "ecs_timer_wheel_t" objects, registry[world][timers] */
+typedef struct ecs_lua_wheel_t
+{
+    uint64_t now;
+    double time; /* Unconsumed delta time */
+
+    ecs_vec_t timers; /* ecs_lua_wheel_timer_t */
+    int32_t free;
+
+    /* Handles of expired timers, dispatched once per frame */
+    ecs_vec_t due; /* lua_Integer */
+
+    int32_t slots[ECS_LUA_WHEEL_LEVELS][ECS_LUA_WHEEL_SLOTS];
+    uint64_t used[ECS_LUA_WHEEL_LEVELS]; /* Bitmask of non-empty slots */
+}ecs_lua_wheel_t;
+
+static ecs_lua_wheel_timer_t *wheel_timer(ecs_lua_wheel_t *wheel, int32_t i)
+{
+    return ecs_vec_get_t(&wheel->timers, ecs_lua_wheel_timer_t, i);
+}
+
+static lua_Integer timer_handle(ecs_lua_wheel_t *wheel, int32_t i)
+{
+    return ((lua_Integer)wheel_timer(wheel, i)->generation << 32) | (uint32_t)(i + 1);
+}
+
+/* Returns the timer index for a handle, -1 if it expired or was cancelled */
+static int32_t timer_index(ecs_lua_wheel_t *wheel, lua_Integer handle)
+{
+    int32_t i = (int32_t)(uint32_t)handle - 1;
+
+    if(i < 0 || i >= ecs_vec_count(&wheel->timers)) return -1;
+
+    ecs_lua_wheel_timer_t *t = wheel_timer(wheel, i);
+
+    if(t->func_ref == LUA_NOREF || t->generation != (uint32_t)(handle >> 32)) return -1;
+
+    return i;
+}
+
+static void slot_used(ecs_lua_wheel_t *wheel, int32_t *head, bool used)
+{
+    int32_t slot = (int32_t)(head - &wheel->slots[0][0]);
+    uint64_t bit = (uint64_t)1 << (slot & ECS_LUA_WHEEL_MASK);
+
+    if(used) wheel->used[slot >> ECS_LUA_WHEEL_BITS] |= bit;
+    else wheel->used[slot >> ECS_LUA_WHEEL_BITS] &= ~bit;
+}
+
+static void wheel_unlink(ecs_lua_wheel_t *wheel, int32_t i)
+{
+    ecs_lua_wheel_timer_t *t = wheel_timer(wheel, i);
+
+    if(t->prev != -1) wheel_timer(wheel, t->prev)->next = t->next;
+    else *t->head = t->next;
+
+    if(t->next != -1) wheel_timer(wheel, t->next)->prev = t->prev;
+
+    if(*t->head == -1) slot_used(wheel, t->head, false);
+
+    t->head = NULL;
+}
+
+/* Expects expires > now */
+static void wheel_insert(ecs_lua_wheel_t *wheel, int32_t i)
+{
+    ecs_lua_wheel_timer_t *t = wheel_timer(wheel, i);
+
+    ecs_assert(t->expires > wheel->now, ECS_INTERNAL_ERROR, NULL);
+
+    uint64_t delta = t->expires - wheel->now;
+    int level = 0;
+
+    while(level < ECS_LUA_WHEEL_LEVELS - 1 && delta >= ((uint64_t)1 << (ECS_LUA_WHEEL_BITS * (level + 1))))
+        level++;
+
+    uint64_t expires = t->expires;
+    uint64_t max = wheel->now + ((uint64_t)1 << (ECS_LUA_WHEEL_BITS * ECS_LUA_WHEEL_LEVELS)) - 1;
+
+    /* Beyond the range of the wheel, reinserted when the last level cascades */
+    if(expires > max) expires = max;
+
+    int32_t *head = &wheel->slots[level][(expires >> (ECS_LUA_WHEEL_BITS * level)) & ECS_LUA_WHEEL_MASK];
+
+    t->prev = -1;
+    t->next = *head;
+    t->head = head;
+
+    if(*head != -1) wheel_timer(wheel, *head)->prev = i;
+
+    *head = i;
+
+    slot_used(wheel, head, true);
+}
+
+/* Moves the timers of a slot to lower levels, or to due if expired */
+static void wheel_cascade(ecs_lua_wheel_t *wheel, int32_t *head)
+{
+    int32_t i = *head;
+
+    *head = -1;
+    slot_used(wheel, head, false);
+
+    while(i != -1)
+    {
+        ecs_lua_wheel_timer_t *t = wheel_timer(wheel, i);
+        int32_t next = t->next;
+
+        t->head = NULL;
+
+        if(t->expires <= wheel->now) *ecs_vec_append_t(NULL, &wheel->due, lua_Integer) = timer_handle(wheel, i);
+        else wheel_insert(wheel, i);
+
+        i = next;
+    }
+}
+
+/* Returns the first tick after now at which a non-empty slot is processed */
+static uint64_t wheel_next(ecs_lua_wheel_t *wheel)
+{
+    uint64_t next = UINT64_MAX;
+    int level;
+
+    for(level = 0; level < ECS_LUA_WHEEL_LEVELS; level++)
+    {
+        int shift = ECS_LUA_WHEEL_BITS * level;
+        uint64_t used = wheel->used[level];
+
+        if(!used) continue;
+
+        /* The next tick aligned to the level, and the slot it processes */
+        uint64_t tick = ((wheel->now >> shift) + 1) << shift;
+        int slot = (int)((tick >> shift) & ECS_LUA_WHEEL_MASK);
+        int k = 0;
+
+        if(slot) used = (used >> slot) | (used << (ECS_LUA_WHEEL_SLOTS - slot));
+
+        while(!(used & 1))
+        {
+            used >>= 1;
+            k++;
+        }
+
+        tick += (uint64_t)k << shift;
+
+        if(tick < next) next = tick;
+    }
+
+    return next;
+}
+
+static void wheel_advance(ecs_lua_wheel_t *wheel, uint64_t ticks)
+{
+    uint64_t end = wheel->now + ticks;
+
+    while(wheel->now < end)
+    {
+        /* Skip ahead over empty slots */
+        uint64_t now = wheel_next(wheel);
+
+        if(now > end)
+        {
+            wheel->now = end;
+            break;
+        }
+
+        wheel->now = now;
+        int level;
+
+        /* Cascade higher levels when the lower level wraps around */
+        for(level = ECS_LUA_WHEEL_LEVELS - 1; level > 0; level--)
+        {
+            if(now & (((uint64_t)1 << (ECS_LUA_WHEEL_BITS * level)) - 1)) continue;
+
+            wheel_cascade(wheel, &wheel->slots[level][(now >> (ECS_LUA_WHEEL_BITS * level)) & ECS_LUA_WHEEL_MASK]);
+        }
+
+        wheel_cascade(wheel, &wheel->slots[0][now & ECS_LUA_WHEEL_MASK]);
+    }
+}
+
+static void timer_free(lua_State *L, ecs_world_t *w, ecs_lua_wheel_t *wheel, int32_t i)
+{
+    ecs_lua_wheel_timer_t *t = wheel_timer(wheel, i);
+
+    if(t->head) wheel_unlink(wheel, i);
+
+    ecs_lua_unref(L, w, t->func_ref);
+
+    t->func_ref = LUA_NOREF;
+    t->generation++;
+    t->next = wheel->free;
+    wheel->free = i;
+}
+
+int wheel_gc(lua_State *L)
+{
+    ecs_lua_wheel_t *wheel = luaL_checkudata(L, 1, "ecs_timer_wheel_t");
+
+    ecs_vec_fini_t(NULL, &wheel->timers, ecs_lua_wheel_timer_t);
+    ecs_vec_fini_t(NULL, &wheel->due, lua_Integer);
+
+    return 0;
+}
+
+/* Returns the wheel of the world, NULL if it was not created */
+static ecs_lua_wheel_t *get_wheel(lua_State *L, const ecs_world_t *real_world)
+{
+    ecs_lua_wheel_t *wheel = NULL;
+
+    if(lua_rawgetp(L, LUA_REGISTRYINDEX, real_world) == LUA_TTABLE)
+    {
+        if(lua_rawgeti(L, -1, ECS_LUA_TIMERS) == LUA_TUSERDATA) wheel = lua_touserdata(L, -1);
+
+        lua_pop(L, 1);
+    }
+
+    lua_pop(L, 1);
+
+    return wheel;
+}
+
+/* Runs the callbacks of expired timers */
+static void TimerWheel(ecs_iter_t *it)
+{
+    ecs_world_t *w = it->world;
+    const ecs_world_t *real_world = ecs_get_world(w);
+
+    const EcsLuaHost *host = ecs_singleton_get(w, EcsLuaHost);
+
+    /* No Lua state yet */
+    if(!host) return;
+
+    lua_State *L = host->L;
+
+    /* The wheel is owned by the Lua state, it is looked up every frame
+       so the system never outlives it */
+    ecs_lua_wheel_t *wheel = get_wheel(L, real_world);
+
+    if(!wheel) return;
+
+    wheel->time += it->delta_time;
+
+    uint64_t ticks = (uint64_t)(wheel->time * ECS_LUA_WHEEL_HZ);
+    wheel->time -= (double)ticks / ECS_LUA_WHEEL_HZ;
+
+    wheel_advance(wheel, ticks);
+
+    int32_t n, count = ecs_vec_count(&wheel->due);
+
+    if(!count) return;
+
+    ecs_lua__prolog(L);
+
+    ecs_world_t **wbuf = world_buf(L, real_world);
+
+    ecs_world_t *prev_world = *wbuf;
+    *wbuf = w;
+
+    /* Timers added by callbacks are scheduled after now, due is not modified */
+    for(n=0; n < count; n++)
+    {
+        lua_Integer handle = *ecs_vec_get_t(&wheel->due, lua_Integer, n);
+        int32_t i = timer_index(wheel, handle);
+
+        /* Cancelled by an earlier callback */
+        if(i == -1) continue;
+
+        ecs_lua_wheel_timer_t *t;
+
+        /* Repeating timers fire once for every interval that elapsed,
+           the schedule does not drift after a long frame */
+        do
+        {
+            t = wheel_timer(wheel, i);
+
+            ecs_lua_rawgeti(L, (ecs_world_t*)real_world, t->func_ref);
+            lua_pushinteger(L, handle);
+
+            int ret = lua_pcall(L, 1, 0, 0);
+
+            if(ret)
+            {
+                const char *err = lua_tostring(L, lua_gettop(L));
+                ecs_os_err("error in timer callback (%d): %s", ret, err);
+                lua_pop(L, 1);
+            }
+
+            /* The callback may have cancelled its own timer */
+            if(timer_index(wheel, handle) == -1) break;
+
+            t = wheel_timer(wheel, i);
+
+            if(!t->interval)
+            {
+                timer_free(L, (ecs_world_t*)real_world, wheel, i);
+                break;
+            }
+
+            t->expires += t->interval;
+        }while(t->expires <= wheel->now);
+
+        if(timer_index(wheel, handle) != -1) wheel_insert(wheel, i);
+    }
+
+    ecs_vec_clear(&wheel->due);
+
+    *wbuf = prev_world;
+
+    ecs_lua__epilog(L);
+}
+
+void ecs_lua_timer_init(ecs_world_t *world)
+{
+    ecs_entity_desc_t edesc = {0};
+    edesc.name = "TimerWheel";
+    edesc.add[0] = ecs_dependson(EcsPreUpdate);
+    edesc.add[1] = EcsPreUpdate;
+
+    ecs_system_desc_t desc = {0};
+    desc.entity = ecs_entity_init(world, &edesc);
+    desc.callback = TimerWheel;
+
+    ecs_system_init(world, &desc);
+}
+
+/* Pushes nothing, returns the wheel of the world, it is created on first use.
+   Does not modify the world, timers can be added from systems */
+static ecs_lua_wheel_t *check_wheel(lua_State *L, ecs_world_t *w)
+{
+    const ecs_world_t *real_world = ecs_get_world(w);
+
+    ecs_lua_wheel_t *wheel = get_wheel(L, real_world);
+
+    if(wheel) return wheel;
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, real_world);
+
+    wheel = lua_newuserdata(L, sizeof(ecs_lua_wheel_t));
+
+    memset(wheel, 0, sizeof(ecs_lua_wheel_t));
+    memset(wheel->slots, -1, sizeof(wheel->slots));
+    wheel->free = -1;
+
+    ecs_vec_init_t(NULL, &wheel->timers, ecs_lua_wheel_timer_t, 0);
+    ecs_vec_init_t(NULL, &wheel->due, lua_Integer, 0);
+
+    luaL_setmetatable(L, "ecs_timer_wheel_t");
+    lua_rawseti(L, -2, ECS_LUA_TIMERS);
+    lua_pop(L, 1);
+
+    return wheel;
+}
+
+static int add_timer(lua_State *L, bool repeat)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    lua_Number seconds = luaL_checknumber(L, 1);
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+
+    if(!(seconds >= 0) || seconds > 1e9) return luaL_argerror(L, 1, "invalid duration");
+
+    ecs_lua_wheel_t *wheel = check_wheel(L, w);
+
+    /* Rounded up so timers never fire early */
+    uint64_t ticks = (uint64_t)ceil(seconds * ECS_LUA_WHEEL_HZ);
+    int32_t i = wheel->free;
+
+    if(i != -1) wheel->free = wheel_timer(wheel, i)->next;
+    else
+    {
+        i = ecs_vec_count(&wheel->timers);
+        ecs_vec_append_t(NULL, &wheel->timers, ecs_lua_wheel_timer_t)->generation = 0;
+    }
+
+    ecs_lua_wheel_timer_t *t = wheel_timer(wheel, i);
+
+    lua_pushvalue(L, 2);
+    t->func_ref = ecs_lua_ref(L, w);
+    t->expires = wheel->now + (ticks ? ticks : 1);
+    t->interval = repeat ? (ticks ? ticks : 1) : 0;
+    t->head = NULL;
+
+    wheel_insert(wheel, i);
+
+    lua_pushinteger(L, timer_handle(wheel, i));
+
+    return 1;
+}
+
+int timer_after(lua_State *L)
+{
+    return add_timer(L, false);
+}
+
+int timer_every(lua_State *L)
+{
+    return add_timer(L, true);
+}
+
+int timer_cancel(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+    lua_Integer handle = luaL_checkinteger(L, 1);
+
+    ecs_lua_wheel_t *wheel = get_wheel(L, ecs_get_world(w));
+    int32_t i = wheel ? timer_index(wheel, handle) : -1;
+
+    if(i != -1) timer_free(L, w, wheel, i);
+
+    lua_pushboolean(L, i != -1);
+
+    return 1;
+}
@@ -0,0 +1,180 @@
+#include "private.h"
+
+#include <stdio.h>
+
+#define ECS_LUA_TRACE_NAME (64)
+
+typedef struct ecs_lua_trace_span_t
+{
+    double ts; /* microseconds since ecs.trace_start() */
+    double dur;
+    const char *cat;
+    char name[ECS_LUA_TRACE_NAME];
+}ecs_lua_trace_span_t;
+
+/* Ring buffer of spans, the oldest spans are overwritten when full.
+   Userdata in registry[&tracer_key], each Lua state has its own tracer
+   so spans are only written by the thread running the state */
+typedef struct ecs_lua_trace_t
+{
+    ecs_time_t start;
+    int32_t head; /* Total spans recorded */
+    int32_t mask;
+    ecs_lua_trace_span_t spans[];
+}ecs_lua_trace_t;
+
+static const char tracer_key = 't';
+
+static ecs_lua_trace_t *get_tracer(lua_State *L)
+{
+    ecs_lua_trace_t *t = NULL;
+
+    if(lua_rawgetp(L, LUA_REGISTRYINDEX, &tracer_key) == LUA_TUSERDATA) t = lua_touserdata(L, -1);
+
+    lua_pop(L, 1);
+
+    return t;
+}
+
+static double time_us(const ecs_lua_trace_t *t, const ecs_time_t *time)
+{
+    ecs_time_t diff = ecs_time_sub(*time, t->start);
+    return ecs_time_to_double(diff) * 1000000.0;
+}
+
+bool ecs_lua_trace_begin(lua_State *L, ecs_time_t *start)
+{
+    if(!get_tracer(L)) return false;
+
+    ecs_os_get_time(start);
+
+    return true;
+}
+
+void ecs_lua_trace_end(lua_State *L, const ecs_time_t *start, const char *cat, const char *name)
+{
+    /* Tracing may have been stopped during the span */
+    ecs_lua_trace_t *t = get_tracer(L);
+
+    if(!t) return;
+
+    ecs_time_t now;
+    ecs_os_get_time(&now);
+
+    int32_t i = t->head++ & t->mask;
+    ecs_lua_trace_span_t *span = &t->spans[i];
+
+    span->ts = time_us(t, start);
+    span->dur = time_us(t, &now) - span->ts;
+    span->cat = cat;
+    ecs_os_strncpy(span->name, name ? name : "", ECS_LUA_TRACE_NAME - 1);
+    span->name[ECS_LUA_TRACE_NAME - 1] = '\0';
+}
+
+static void append_json_string(ecs_strbuf_t *buf, const char *str)
+{
+    ecs_strbuf_appendch(buf, '"');
+
+    for(; *str; str++)
+    {
+        unsigned char c = *str;
+
+        if(c == '"' || c == '\\') ecs_strbuf_append(buf, "\\%c", c);
+        else if(c < 0x20) ecs_strbuf_append(buf, "\\u%04x", c);
+        else ecs_strbuf_appendch(buf, c);
+    }
+
+    ecs_strbuf_appendch(buf, '"');
+}
+
+static char *trace_json(const ecs_lua_trace_t *t, int32_t *count)
+{
+    int32_t capacity = t->mask + 1;
+    int32_t n = t->head < capacity ? t->head : capacity;
+    int32_t i, first = t->head - n;
+
+    ecs_strbuf_t buf = ECS_STRBUF_INIT;
+    ecs_strbuf_appendstr(&buf, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    for(i=0; i < n; i++)
+    {
+        const ecs_lua_trace_span_t *span = &t->spans[(first + i) & t->mask];
+
+        if(i) ecs_strbuf_appendch(&buf, ',');
+
+        ecs_strbuf_appendstr(&buf, "\n{\"name\":");
+        append_json_string(&buf, span->name);
+        ecs_strbuf_appendstr(&buf, ",\"cat\":");
+        append_json_string(&buf, span->cat);
+        ecs_strbuf_append(&buf, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+            span->ts, span->dur);
+    }
+
+    ecs_strbuf_appendstr(&buf, "\n]}\n");
+
+    *count = n;
+
+    return ecs_strbuf_get(&buf);
+}
+
+int trace_start(lua_State *L)
+{
+    lua_Integer capacity = luaL_optinteger(L, 1, 65536);
+
+    if(capacity < 1 || capacity > (1 << 24)) return luaL_argerror(L, 1, "capacity out of range");
+
+    if(get_tracer(L)) return luaL_error(L, "tracing is already enabled");
+
+    int32_t size = 1;
+    while(size < capacity) size <<= 1;
+
+    ecs_lua_trace_t *t = lua_newuserdata(L, sizeof(ecs_lua_trace_t) + size * sizeof(ecs_lua_trace_span_t));
+
+    t->head = 0;
+    t->mask = size - 1;
+    ecs_os_get_time(&t->start);
+
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &tracer_key);
+
+    return 0;
+}
+
+int trace_stop(lua_State *L)
+{
+    const char *path = luaL_optstring(L, 1, NULL);
+    ecs_lua_trace_t *t = get_tracer(L);
+
+    if(!t) return luaL_error(L, "tracing is not enabled");
+
+    int32_t count;
+    char *json = trace_json(t, &count);
+
+    /* The ring is freed by the collector */
+    lua_pushnil(L);
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &tracer_key);
+
+    if(!path)
+    {
+        lua_pushstring(L, json);
+        ecs_os_free(json);
+        return 1;
+    }
+
+    FILE *f = fopen(path, "wb");
+    int err = 1;
+
+    if(f)
+    {
+        size_t len = strlen(json);
+        err = fwrite(json, 1, len, f) != len;
+        err |= fclose(f);
+    }
+
+    ecs_os_free(json);
+
+    if(err) return luaL_error(L, "failed to write %s", path);
+
+    lua_pushinteger(L, count);
+
+    return 1;
+}
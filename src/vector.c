@@ -0,0 +1,351 @@
+#include "private.h"
+
+/* Userdata of "ecs_vector_view_t" objects */
+typedef struct ecs_lua_vector_view_t
+{
+    ecs_entity_t entity;
+    ecs_entity_t component;
+
+    /* ecs_vec_t member */
+    int32_t offset;
+
+    /* Element type */
+    ecs_entity_t type;
+    ecs_size_t size;
+
+    /* Elements are returned as proxies */
+    bool is_struct;
+}ecs_lua_vector_view_t;
+
+/* Userdata of "ecs_vector_elem_t" objects, the uservalue is the view */
+typedef struct ecs_lua_vector_elem_t
+{
+    int32_t index;
+
+    /* Struct (member) within the element */
+    int32_t offset;
+    ecs_entity_t type;
+}ecs_lua_vector_elem_t;
+
+static ecs_lua_vector_view_t *checkview(lua_State *L, int arg)
+{
+    return luaL_checkudata(L, arg, "ecs_vector_view_t");
+}
+
+/* The vector is looked up for every access, component storage may move */
+static ecs_vec_t *view_vec(lua_State *L, ecs_world_t *w, const ecs_lua_vector_view_t *view, bool mut)
+{
+    if(!ecs_is_alive(w, view->entity) || !ecs_has_id(w, view->entity, view->component))
+        luaL_error(L, "vector owner no longer has the component");
+
+    void *ptr;
+
+    if(mut) ptr = ecs_get_mut_id(w, view->entity, view->component);
+    else ptr = (void*)ecs_get_id(w, view->entity, view->component);
+
+    return ECS_OFFSET(ptr, view->offset);
+}
+
+static int32_t check_index(lua_State *L, const ecs_vec_t *vec, int arg)
+{
+    lua_Integer i = luaL_checkinteger(L, arg);
+
+    if(i < 1 || i > ecs_vec_count(vec)) luaL_argerror(L, arg, "index out of range");
+
+    return (int32_t)(i - 1);
+}
+
+static void construct(ecs_world_t *w, const ecs_lua_vector_view_t *view, void *ptr, int32_t count)
+{
+    const ecs_type_info_t *ti = ecs_get_type_info(w, view->type);
+
+    if(ti && ti->hooks.ctor) ti->hooks.ctor(ptr, count, ti);
+    else memset(ptr, 0, view->size * count);
+}
+
+static void destruct(ecs_world_t *w, const ecs_lua_vector_view_t *view, void *ptr, int32_t count)
+{
+    const ecs_type_info_t *ti = ecs_get_type_info(w, view->type);
+
+    if(ti && ti->hooks.dtor) ti->hooks.dtor(ptr, count, ti);
+}
+
+static void push_elem(lua_State *L, int view_idx, int32_t index, int32_t offset, ecs_entity_t type)
+{
+    view_idx = lua_absindex(L, view_idx);
+
+    ecs_lua_vector_elem_t *elem = lua_newuserdata(L, sizeof(ecs_lua_vector_elem_t));
+
+    elem->index = index;
+    elem->offset = offset;
+    elem->type = type;
+
+    lua_pushvalue(L, view_idx);
+    lua_setuservalue(L, -2);
+
+    luaL_setmetatable(L, "ecs_vector_elem_t");
+}
+
+/* The element is resolved for every access, it may have been removed */
+static void *elem_ptr(lua_State *L, int arg, ecs_world_t **w, ecs_lua_vector_view_t **view, bool mut)
+{
+    ecs_lua_vector_elem_t *elem = luaL_checkudata(L, arg, "ecs_vector_elem_t");
+
+    lua_getuservalue(L, arg);
+    *view = lua_touserdata(L, -1);
+    *w = ecs_lua_object_world(L, -1);
+    lua_pop(L, 1);
+
+    ecs_vec_t *vec = view_vec(L, *w, *view, mut);
+
+    if(elem->index >= ecs_vec_count(vec)) luaL_error(L, "vector element no longer exists");
+
+    return ECS_OFFSET(ecs_vec_get(vec, (*view)->size, elem->index), elem->offset);
+}
+
+/* Replace an element proxy with a copy, assigned storage may move */
+static void elem_to_value(lua_State *L, int arg)
+{
+    if(!luaL_testudata(L, arg, "ecs_vector_elem_t")) return;
+
+    ecs_lua_vector_elem_t *elem = lua_touserdata(L, arg);
+    ecs_lua_vector_view_t *view;
+    ecs_world_t *w;
+
+    void *ptr = elem_ptr(L, arg, &w, &view, false);
+
+    ecs_ptr_to_lua(w, L, elem->type, ptr);
+    lua_replace(L, arg);
+}
+
+int vector__index(lua_State *L)
+{
+    ecs_lua_vector_view_t *view = checkview(L, 1);
+
+    if(lua_type(L, 2) != LUA_TNUMBER)
+    {/* methods */
+        lua_pushvalue(L, 2);
+        lua_rawget(L, lua_upvalueindex(1));
+        return 1;
+    }
+
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+    ecs_vec_t *vec = view_vec(L, w, view, false);
+
+    lua_Integer i = luaL_checkinteger(L, 2);
+
+    if(i < 1 || i > ecs_vec_count(vec)) return 0;
+
+    if(view->is_struct) push_elem(L, 1, (int32_t)(i - 1), 0, view->type);
+    else ecs_ptr_to_lua(w, L, view->type, ecs_vec_get(vec, view->size, i - 1));
+
+    return 1;
+}
+
+int vector__newindex(lua_State *L)
+{
+    ecs_lua_vector_view_t *view = checkview(L, 1);
+    elem_to_value(L, 3);
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+    ecs_vec_t *vec = view_vec(L, w, view, true);
+
+    lua_Integer i = luaL_checkinteger(L, 2);
+    void *ptr;
+
+    if(i == ecs_vec_count(vec) + 1)
+    {
+        ptr = ecs_vec_append(NULL, vec, view->size);
+        construct(w, view, ptr, 1);
+    }
+    else ptr = ecs_vec_get(vec, view->size, check_index(L, vec, 2));
+
+    ecs_lua_to_ptr(w, L, 3, view->type, ptr);
+
+    ecs_modified_id(w, view->entity, view->component);
+
+    return 0;
+}
+
+int vector__len(lua_State *L)
+{
+    ecs_lua_vector_view_t *view = checkview(L, 1);
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+    ecs_vec_t *vec = view_vec(L, w, view, false);
+
+    lua_pushinteger(L, ecs_vec_count(vec));
+
+    return 1;
+}
+
+int vector_get(lua_State *L)
+{
+    ecs_lua_vector_view_t *view = checkview(L, 1);
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+    ecs_vec_t *vec = view_vec(L, w, view, false);
+
+    void *ptr = ecs_vec_get(vec, view->size, check_index(L, vec, 2));
+
+    ecs_ptr_to_lua(w, L, view->type, ptr);
+
+    return 1;
+}
+
+int vector_push(lua_State *L)
+{
+    ecs_lua_vector_view_t *view = checkview(L, 1);
+    elem_to_value(L, 2);
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+    ecs_vec_t *vec = view_vec(L, w, view, true);
+
+    void *ptr = ecs_vec_append(NULL, vec, view->size);
+
+    construct(w, view, ptr, 1);
+
+    if(!lua_isnoneornil(L, 2)) ecs_lua_to_ptr(w, L, 2, view->type, ptr);
+
+    ecs_modified_id(w, view->entity, view->component);
+
+    lua_pushinteger(L, ecs_vec_count(vec));
+
+    return 1;
+}
+
+int vector_pop(lua_State *L)
+{
+    ecs_lua_vector_view_t *view = checkview(L, 1);
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+    ecs_vec_t *vec = view_vec(L, w, view, true);
+
+    int32_t count = ecs_vec_count(vec);
+
+    if(!count) return 0;
+
+    void *ptr = ecs_vec_get(vec, view->size, count - 1);
+
+    ecs_ptr_to_lua(w, L, view->type, ptr);
+
+    destruct(w, view, ptr, 1);
+    ecs_vec_remove_last(vec);
+
+    ecs_modified_id(w, view->entity, view->component);
+
+    return 1;
+}
+
+int vector_resize(lua_State *L)
+{
+    ecs_lua_vector_view_t *view = checkview(L, 1);
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+    lua_Integer size = luaL_checkinteger(L, 2);
+
+    if(size < 0 || size > INT32_MAX) luaL_argerror(L, 2, "size out of range");
+
+    ecs_vec_t *vec = view_vec(L, w, view, true);
+
+    int32_t count = ecs_vec_count(vec);
+    int32_t new_count = (int32_t)size;
+
+    if(new_count < count)
+    {
+        destruct(w, view, ecs_vec_get(vec, view->size, new_count), count - new_count);
+        ecs_vec_set_count(NULL, vec, view->size, new_count);
+    }
+    else if(new_count > count)
+    {
+        ecs_vec_set_count(NULL, vec, view->size, new_count);
+        construct(w, view, ecs_vec_get(vec, view->size, count), new_count - count);
+    }
+
+    ecs_modified_id(w, view->entity, view->component);
+
+    return 0;
+}
+
+int vector_view(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    ecs_entity_t e = checkentity(L, w, 1);
+    ecs_entity_t component = luaL_checkinteger(L, 2);
+    const char *member = luaL_optstring(L, 3, NULL);
+
+    if(!ecs_get(w, component, EcsMetaTypeSerialized)) luaL_argerror(L, 2, "component has no reflection data");
+
+    ecs_entity_t type = component;
+    int32_t offset = 0;
+
+    if(member && ecs_lua_member(w, component, member, &type, &offset))
+        luaL_argerror(L, 3, "invalid member");
+
+    const EcsVector *v = ecs_get(w, type, EcsVector);
+
+    if(!v) return luaL_argerror(L, member ? 3 : 2, "not a vector");
+
+    const EcsComponent *elem = ecs_get(w, v->type, EcsComponent);
+    ecs_assert(elem != NULL, ECS_INTERNAL_ERROR, NULL);
+
+    ecs_lua_vector_view_t *view = lua_newuserdata(L, sizeof(ecs_lua_vector_view_t));
+
+    view->entity = e;
+    view->component = component;
+    view->offset = offset;
+    view->type = v->type;
+    view->size = elem->size;
+    view->is_struct = ecs_has(w, v->type, EcsStruct);
+
+    /* Associate world with the object for sanity checks */
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_setuservalue(L, -2);
+
+    luaL_setmetatable(L, "ecs_vector_view_t");
+
+    return 1;
+}
+
+int vector_elem__index(lua_State *L)
+{
+    ecs_lua_vector_elem_t *elem = luaL_checkudata(L, 1, "ecs_vector_elem_t");
+    ecs_lua_vector_view_t *view;
+    ecs_world_t *w;
+
+    if(lua_type(L, 2) != LUA_TSTRING) return 0;
+
+    void *ptr = elem_ptr(L, 1, &w, &view, false);
+
+    ecs_entity_t type;
+    int32_t offset;
+
+    if(ecs_lua_member(w, elem->type, lua_tostring(L, 2), &type, &offset)) return 0;
+
+    if(ecs_has(w, type, EcsStruct))
+    {/* nested structs are proxied as well */
+        lua_getuservalue(L, 1);
+        push_elem(L, -1, elem->index, elem->offset + offset, type);
+    }
+    else ecs_ptr_to_lua(w, L, type, ECS_OFFSET(ptr, offset));
+
+    return 1;
+}
+
+int vector_elem__newindex(lua_State *L)
+{
+    ecs_lua_vector_elem_t *elem = luaL_checkudata(L, 1, "ecs_vector_elem_t");
+    const char *name = luaL_checkstring(L, 2);
+    ecs_lua_vector_view_t *view;
+    ecs_world_t *w;
+
+    elem_to_value(L, 3);
+
+    void *ptr = elem_ptr(L, 1, &w, &view, true);
+
+    ecs_entity_t type;
+    int32_t offset;
+
+    if(ecs_lua_member(w, elem->type, name, &type, &offset)) return luaL_argerror(L, 2, "invalid member");
+
+    ecs_lua_to_ptr(w, L, 3, type, ECS_OFFSET(ptr, offset));
+
+    ecs_modified_id(w, view->entity, view->component);
+
+    return 0;
+}
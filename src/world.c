@@ -25,29 +25,42 @@ int world_new(lua_State *L)
     return 1;
 }
 
-int world_gc(lua_State *L)
+/* Calls __gc on the userdata keys of the table on top of the stack */
+static void collect_table(lua_State *L)
 {
-    ecs_world_t *wdefault = ecs_lua_get_world(L);
-    ecs_world_t **ptr = lua_touserdata(L, 1);
-    ecs_world_t *w = *ptr;
-
-    if(!w) return 0;
-
-    lua_rawgetp(L, LUA_REGISTRYINDEX, w);
-    lua_rawgeti(L, -1, ECS_LUA_COLLECT);
-
     int idx = lua_absindex(L, -1);
 
     lua_pushnil(L);
 
     while(lua_next(L, idx))
     {
-        int ret = luaL_callmeta(L, -2, "__gc");
+        lua_pop(L, 1);
+
+        if(lua_type(L, -1) != LUA_TUSERDATA) continue;
+
+        int ret = luaL_callmeta(L, -1, "__gc");
         ecs_assert(ret != 0, ECS_INTERNAL_ERROR, NULL);
 
-        lua_pop(L, 2); /* callmeta pushes a value */
+        lua_pop(L, 1); /* callmeta pushes a value */
     }
+}
 
+int world_gc(lua_State *L)
+{
+    ecs_world_t *wdefault = ecs_lua_get_world(L);
+    ecs_world_t **ptr = lua_touserdata(L, 1);
+    ecs_world_t *w = *ptr;
+
+    if(!w) return 0;
+
+    lua_rawgetp(L, LUA_REGISTRYINDEX, w);
+
+    lua_rawgeti(L, -1, ECS_LUA_COLLECT);
+    collect_table(L);
+    lua_pop(L, 1);
+
+    lua_rawgeti(L, -1, ECS_LUA_FILTERS);
+    collect_table(L);
     lua_pop(L, 2);
 
     if(w != wdefault)
@@ -117,7 +130,7 @@ int world_stats(lua_State *L)
     //sizeof(EcsLuaWorldStats)
     //sizeof(ecs_world_stats_t)
 
-    EcsLuaWorldStats ws;
+    EcsLuaWorldStats ws = {0};
     ecs_world_stats_get(w, (ecs_world_stats_t*)&ws);
 
     ecs_ptr_to_lua(w, L, ecs_id(EcsLuaWorldStats), &ws);
@@ -125,6 +138,80 @@ int world_stats(lua_State *L)
     return 1;
 }
 
+/* Userdata of "ecs_world_stats_view_t" objects */
+typedef struct ecs_lua_stats_view_t
+{
+    ecs_world_stats_t stats;
+    bool latest;
+}ecs_lua_stats_view_t;
+
+int stats_view__index(lua_State *L)
+{
+    ecs_lua_stats_view_t *view = luaL_checkudata(L, 1, "ecs_world_stats_view_t");
+    const char *name = luaL_checkstring(L, 2);
+
+    /* methods */
+    lua_pushvalue(L, 2);
+    if(lua_rawget(L, lua_upvalueindex(1)) != LUA_TNIL) return 1;
+
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+
+    if(!strcmp(name, "t"))
+    {
+        lua_pushinteger(L, view->stats.t);
+        return 1;
+    }
+
+    ecs_entity_t type;
+    int32_t offset;
+
+    if(ecs_lua_member(w, ecs_id(EcsLuaWorldStats), name, &type, &offset) ||
+       (type != ecs_id(EcsLuaGauge) && type != ecs_id(EcsLuaCounter)))
+    {
+        return luaL_argerror(L, 2, "invalid stat");
+    }
+
+    const ecs_metric_t *m = ECS_OFFSET(&view->stats, offset);
+
+    if(!view->latest) ecs_ptr_to_lua(w, L, type, m);
+    else if(type == ecs_id(EcsLuaGauge)) lua_pushnumber(L, m->gauge.avg[view->stats.t]);
+    else lua_pushnumber(L, m->counter.value[view->stats.t]);
+
+    return 1;
+}
+
+int stats_view_update(lua_State *L)
+{
+    ecs_lua_stats_view_t *view = luaL_checkudata(L, 1, "ecs_world_stats_view_t");
+    ecs_world_t *w = ecs_lua_object_world(L, 1);
+
+    ecs_world_stats_get(w, &view->stats);
+
+    lua_settop(L, 1);
+
+    return 1;
+}
+
+int world_stats_view(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_world(L);
+
+    ecs_lua_stats_view_t *view = lua_newuserdata(L, sizeof(ecs_lua_stats_view_t));
+    memset(view, 0, sizeof(ecs_lua_stats_view_t));
+
+    view->latest = lua_toboolean(L, 1);
+
+    /* Associate world with the object for sanity checks */
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_setuservalue(L, -2);
+
+    luaL_setmetatable(L, "ecs_world_stats_view_t");
+
+    ecs_world_stats_get(w, &view->stats);
+
+    return 1;
+}
+
 int dim(lua_State *L)
 {
     ecs_world_t *w = ecs_lua_world(L);
@@ -141,6 +141,72 @@ ecs.delete(child)
 assert(ecs.exists(child))
 assert(not ecs.is_alive(child))
 
+--Hierarchy traversal
+local root = ecs.new()
+local a, b = ecs.new(), ecs.new()
+local a1, a2, b1 = ecs.new(), ecs.new(), ecs.new()
+local a11 = ecs.new()
+
+ecs.add(a, ecs.ChildOf, root)
+ecs.add(b, ecs.ChildOf, root)
+ecs.add(a1, ecs.ChildOf, a)
+ecs.add(a2, ecs.ChildOf, a)
+ecs.add(b1, ecs.ChildOf, b)
+ecs.add(a11, ecs.ChildOf, a1)
+
+u.asserteq(ecs.get_child_count(root), 2)
+u.asserteq(ecs.get_child_count(a), 2)
+u.asserteq(ecs.get_child_count(a11), 0)
+u.asserteq(#ecs.children(root), 2)
+u.asserteq(#ecs.children(a11), 0)
+
+local bfs = ecs.descendants(root)
+u.asserteq(#bfs, 6)
+u.asserteq(bfs[#bfs], a11)
+
+local dfs = ecs.descendants(root, { depth_first = true })
+u.asserteq(#dfs, 6)
+
+for i, e in ipairs(dfs) do
+    --parents come before their children
+    local p = ecs.get_parent(e)
+    if p ~= root then
+        local found = false
+        for j = 1, i - 1 do found = found or dfs[j] == p end
+        assert(found)
+    end
+end
+
+u.asserteq(#ecs.descendants(root, { max_depth = 1 }), 2)
+u.asserteq(#ecs.descendants(root, { max_depth = 2 }), 5)
+u.asserteq(#ecs.descendants(root, { max_depth = 2, depth_first = true }), 5)
+assert(not pcall(ecs.descendants, root, { max_depth = 0 }))
+
+--Prefab and disabled children are counted and returned
+local pchild, dchild = ecs.new(), ecs.new()
+ecs.add(pchild, ecs.Prefab)
+ecs.add(dchild, ecs.Disabled)
+ecs.add(pchild, ecs.ChildOf, b1)
+ecs.add(dchild, ecs.ChildOf, b1)
+u.asserteq(ecs.get_child_count(b1), 2)
+u.asserteq(#ecs.children(b1), 2)
+u.asserteq(#ecs.descendants(root), 8)
+ecs.delete(pchild)
+ecs.delete(dchild)
+
+--Deep hierarchies don't recurse on the C stack
+local deep = ecs.new()
+local leaf = deep
+for i = 1, 1000 do
+    local child = ecs.new()
+    ecs.add(child, ecs.ChildOf, leaf)
+    leaf = child
+end
+local chain = ecs.descendants(deep, { depth_first = true })
+u.asserteq(#chain, 1000)
+u.asserteq(chain[#chain], leaf)
+ecs.delete(deep)
+
 local tag = ecs.tag("LuaTag")
 local tag2 = ecs.tag("LuaTag2")
 
@@ -209,6 +275,42 @@ assert(FlecsLua ~= 0)
 
 assert(ecs.lookup_path(FlecsLua, "WorldInfo") ~= 0)
 
+--Cached lookups are invalidated
+local cached = ecs.set_name(ecs.new(), "lua_cached_name")
+u.asserteq(ecs.lookup("lua_cached_name"), cached)
+u.asserteq(ecs.lookup("lua_cached_name"), cached)
+
+--Generated names don't grow the cache without bound, it is cleared when full
+for i = 1, 300 do u.asserteq(ecs.lookup("lua_generated_" .. i), 0) end
+u.asserteq(ecs.lookup("lua_cached_name"), cached)
+
+ecs.set_name(cached, "lua_renamed")
+u.asserteq(ecs.lookup("lua_cached_name"), 0)
+u.asserteq(ecs.lookup("lua_renamed"), cached)
+
+local cached_parent = ecs.set_name(ecs.new(), "lua_cached_parent")
+u.asserteq(ecs.lookup_fullpath("lua_cached_parent.lua_renamed"), 0)
+u.asserteq(ecs.lookup_path(cached_parent, "lua_renamed"), 0)
+
+ecs.add(cached, ecs.ChildOf, cached_parent)
+u.asserteq(ecs.lookup_fullpath("lua_cached_parent.lua_renamed"), cached)
+u.asserteq(ecs.lookup_path(cached_parent, "lua_renamed"), cached)
+
+ecs.delete(cached)
+u.asserteq(ecs.lookup_fullpath("lua_cached_parent.lua_renamed"), 0)
+u.asserteq(ecs.lookup_path(cached_parent, "lua_renamed"), 0)
+
+--Each world has its own lookup cache
+local lw = ecs.init()
+local lw_e = lw.set_name(lw.new(), "lua_world_cached")
+u.asserteq(lw.lookup("lua_world_cached"), lw_e)
+u.asserteq(ecs.lookup("lua_world_cached"), 0)
+
+lw.set_name(lw_e, "lua_world_renamed")
+u.asserteq(lw.lookup("lua_world_cached"), 0)
+u.asserteq(lw.lookup("lua_world_renamed"), lw_e)
+lw.fini()
+
 
 --Bulk, filters
 
@@ -48,6 +48,79 @@ print("total count: " .. count)
 
 assert(count > 10)
 
+--Compiled filters
+local f = ecs.filter({ terms = Position })
+local f_count = 0
+
+it = ecs.filter_iter(f)
+
+while ecs.filter_next(it) do
+    f_count = f_count + it.count
+end
+
+assert(f_count > 10)
+
+local desc = { terms = Position }
+local it1 = ecs.filter_iter(desc)
+local it2 = ecs.filter_iter(desc)
+assert(getmetatable(it1).__ecs_filter == getmetatable(it2).__ecs_filter)
+
+it1 = ecs.filter_iter("Position")
+it2 = ecs.filter_iter({ expr = "Position" })
+assert(getmetatable(it1).__ecs_filter == getmetatable(it2).__ecs_filter)
+
+count = 0
+while ecs.filter_next(it2) do count = count + it2.count end
+u.asserteq(count, f_count)
+
+assert(not pcall(ecs.filter, "NotAComponent"))
+
+--Unreferenced filter objects are collected, expressions stay usable past the cache size
+local weak = setmetatable({ ecs.filter("Position") }, { __mode = "v" })
+collectgarbage()
+collectgarbage()
+assert(weak[1] == nil)
+
+for i = 1, 300 do
+    local expr = (i % 2 == 0) and "Position" or "Position, ?Velocity"
+    expr = expr .. string.rep(" ", i // 2)
+    it1 = ecs.filter_iter(expr)
+    assert(ecs.filter_next(it1))
+end
+assert(not pcall(ecs.filter_iter, 1))
+
+--Paged and worker iterators
+local function iter_count(it, next)
+    local n = 0
+    while next(it) do n = n + it.count end
+    return n
+end
+
+local total = iter_count(ecs.term_iter(Position), ecs.term_next)
+assert(total > 10)
+
+u.asserteq(iter_count(ecs.page(ecs.term_iter(Position), 0, 10), ecs.iter_next), 10)
+u.asserteq(iter_count(ecs.page(ecs.term_iter(Position), total - 5, 100), ecs.page_next), 5)
+
+local split = 0
+for i = 0, 2 do
+    split = split + iter_count(ecs.worker(ecs.term_iter(Position), i, 3), ecs.worker_next)
+end
+u.asserteq(split, total)
+
+local q = ecs.query("Position")
+it = ecs.page(ecs.query_iter(q), 2, 4)
+count = 0
+while ecs.iter_next(it) do
+    for p, e in ecs.each(it) do
+        count = count + 1
+    end
+end
+u.asserteq(count, 4)
+
+assert(not pcall(ecs.worker, ecs.term_iter(Position), 3, 3))
+
+
 --[[ XXX: this should work on v3
 local ent = ecs.new("ent", "Velocity")
 
@@ -156,3 +156,79 @@ assert(data.z == 333)
 local lol = {}
 lol[ecs.get_type(LuaPosition)] = 245
 assert(not pcall(function () ecs.singleton_set(LuaPosition, lol) end))
+
+--String members
+local Named = ecs.struct("LuaNamed", "{char* name; int32_t x;}")
+local long = string.rep("long string ", 10)
+local named = ecs.set(ecs.new(), Named, { name = long, x = 1 })
+
+u.asserteq(ecs.get(named, Named).name, long)
+u.asserteq(ecs.get(named, Named).name, long)
+
+--Unchanged strings are kept
+ecs.set(named, Named, { name = long, x = 2 })
+u.asserteq(ecs.get(named, Named).name, long)
+u.asserteq(ecs.get(named, Named).x, 2)
+
+ecs.set(named, Named, { name = long .. "!" })
+u.asserteq(ecs.get(named, Named).name, long .. "!")
+
+ecs.set(named, Named, { name = "short" })
+u.asserteq(ecs.get(named, Named).name, "short")
+
+--Vector views
+local Item = ecs.struct("LuaItem", "{int32_t id; float weight;}")
+local ItemVec = ecs.vector("LuaItemVec", Item)
+local Inventory = ecs.struct("LuaInventory", "{int32_t slots; LuaItemVec items;}")
+
+local owner = ecs.set(ecs.new(), Inventory, { slots = 8 })
+local items = ecs.vector_view(owner, Inventory, "items")
+
+u.asserteq(#items, 0)
+u.asserteq(items:push({ id = 1, weight = 0.5 }), 1)
+items:push({ id = 2, weight = 1.5 })
+items[3] = { id = 3, weight = 2 }
+
+u.asserteq(#items, 3)
+u.asserteq(items[2].id, 2)
+u.asserteq(items[3].weight, 2)
+assert(items[4] == nil)
+
+items[2] = { id = 20, weight = 4 }
+u.asserteq(items[2].id, 20)
+u.asserteq(ecs.get(owner, Inventory).items[2].id, 20)
+
+--Struct elements are proxies, get() returns a copy
+items[2].weight = 8
+u.asserteq(items[2].weight, 8)
+u.asserteq(ecs.get(owner, Inventory).items[2].weight, 8)
+
+local copy = items:get(2)
+copy.id = 99
+u.asserteq(items[2].id, 20)
+
+items[1] = items[2]
+u.asserteq(items[1].id, 20)
+items[1] = { id = 1, weight = 0.5 }
+assert(items[2].nope == nil)
+assert(not pcall(function () items[2].nope = 1 end))
+
+local third = items[3]
+local last = items:pop()
+u.asserteq(last.id, 3)
+u.asserteq(#items, 2)
+assert(not pcall(function () return third.id end))
+
+items:resize(5)
+u.asserteq(#items, 5)
+u.asserteq(items[5].id, 0)
+items:resize(1)
+u.asserteq(#items, 1)
+u.asserteq(items[1].id, 1)
+
+assert(not pcall(function () items[3] = { id = 3 } end))
+assert(not pcall(ecs.vector_view, owner, Inventory, "slots"))
+assert(not pcall(ecs.vector_view, owner, Inventory, "nope"))
+
+ecs.remove(owner, Inventory)
+assert(not pcall(function () return #items end))
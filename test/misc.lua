@@ -27,6 +27,27 @@ ecs.err("This is an ERROR message")
 ecs.dbg("This is a DEBUG message")
 ecs.warn("This is a WARN message")
 
+local log_path = os.tmpname()
+ecs.log_open(log_path, { rate = 2 })
+assert(not pcall(ecs.log_open, log_path))
+
+for i = 1, 5 do ecs.err("rate limited", i) end
+ecs.warn("another call site")
+ecs.dbg("below the log level") --discarded before formatting
+
+u.asserteq(ecs.log_close(), 0)
+
+local f = assert(io.open(log_path, "r"))
+local log_text = f:read("*a")
+f:close()
+os.remove(log_path)
+
+local _, limited = log_text:gsub("rate limited", "")
+u.asserteq(limited, 2)
+assert(log_text:find("3 messages suppressed", 1, true)) --pending at close
+assert(log_text:find("warning: .-misc.lua:%d+: another call site"))
+assert(not log_text:find("below the log level", 1, true))
+
 ecs.assert(1)
 ecs.assert(1, "test")
 assert(not pcall(ecs.assert(0)))
@@ -105,6 +126,36 @@ assert(not pcall(function () ecs.meta_constants(ecs.Timer) end))
 --local ws = ecs.world_stats()
 --assert(ws.entity_count ~= 0)
 
+local stats = ecs.world_stats_view(true)
+assert(stats:update() == stats)
+assert(stats.entity_count > 0)
+assert(stats.t >= 0 and stats.t < 60)
+
+local full_stats = ecs.world_stats_view()
+assert(type(full_stats.entity_count.avg) == "table")
+assert(type(full_stats.frame_count.value) == "table")
+assert(not pcall(function () return stats.no_such_stat end))
+assert(not pcall(function () return stats.first_ end))
+
+local export_path = os.tmpname()
+local exported_sys = ecs.system(function () end, "ExportedSystem", ecs.OnUpdate)
+
+assert(not pcall(ecs.export_stats, export_path, 0))
+ecs.export_stats(export_path, 0.5)
+ecs.progress(1)
+ecs.export_stats(nil) --stops and flushes the writer
+
+local f = assert(io.open(export_path, "r"))
+local text = f:read("*a")
+f:close()
+os.remove(export_path)
+
+assert(text:find("flecs_entity_count ", 1, true))
+assert(text:find("# TYPE flecs_frame_count counter", 1, true))
+assert(text:find('flecs_lua_system_calls_total{system="ExportedSystem"} 1', 1, true))
+assert(text:find("# EOF\n$"))
+ecs.delete(exported_sys)
+
 --local e = ecs.lookup_fullpath("flecs.lua.LuaWorldStats")
 --print(ecs.emmy_class(e))
 
@@ -137,6 +188,124 @@ w3.struct("Test", "{int32_t x;}")
 w3.query("Test")
 --Let garbage collection take care of it
 
+--Shards
+local shard_script = assert(package.searchpath("modules.shard", package.path))
+local ok, shard = pcall(ecs.shard_start, shard_script, 1 / 60)
+
+if ok then
+    local start = os.clock()
+    local stats = ecs.shard_stats(shard)
+
+    while stats.running and os.clock() - start < 10 do stats = ecs.shard_stats(shard) end
+
+    assert(not stats.running)
+    u.asserteq(stats.frames, 10)
+    assert(stats.frame_time_max >= stats.frame_time_last)
+
+    ecs.shard_stop(shard)
+    assert(ecs.shard_stats(shard) == nil)
+else
+    assert(shard:find("threading", 1, true), shard)
+end
+
+assert(not pcall(ecs.shard_start, "no_such_script.lua"))
+
+--Channels
+local Transfer = ecs.struct("Transfer", "{int32_t player; float x;}")
+local sender = ecs.channel("transfers", Transfer, 2)
+
+assert(sender:send({ player = 1, x = 0.5 }))
+assert(sender:send({ player = 2 }))
+assert(not sender:send({ player = 3 })) --full
+u.asserteq(#sender, 2)
+
+--Another world with the same type opens the same channel
+local cw = ecs.init()
+local receiver = cw.channel("transfers", cw.struct("Transfer", "{int32_t player; float x;}"))
+local received, last = {}, nil
+
+u.asserteq(receiver:drain(function (t)
+    assert(last == nil or rawequal(last, t))
+    last = t
+    received[#received + 1] = t.player
+end), 2)
+
+u.asserteq(received[1], 1)
+u.asserteq(received[2], 2)
+u.asserteq(#sender, 0)
+assert(not pcall(cw.channel, "transfers", cw.struct("Other", "{int32_t player;}")))
+
+--Same path and size, different members
+local lw = ecs.init()
+assert(not pcall(lw.channel, "transfers", lw.struct("Transfer", "{float x; int32_t player;}")))
+lw.fini()
+
+--Values with heap memory cannot be sent
+ecs.vector("ChannelTransfers", Transfer)
+assert(not pcall(ecs.channel, "names", ecs.struct("ChannelNamed", "{char* name;}")))
+assert(not pcall(ecs.channel, "lists", ecs.struct("ChannelListed", "{ChannelTransfers items;}")))
+
+--Coroutines of the consumer state may drain
+local co_sender = ecs.channel("coroutines", Transfer)
+assert(co_sender:send({ player = 7 }))
+local co_received = 0
+coroutine.wrap(function ()
+    co_received = co_sender:drain(function (t) u.asserteq(t.player, 7) end)
+end)()
+u.asserteq(co_received, 1)
+u.asserteq(co_sender:drain(function () end), 0)
+
+receiver = nil
+collectgarbage()
+cw.fini()
+
+--Bytecode cache: a miss, a hit on reload and a miss once the source changed
+local chunk = os.tmpname()
+local cache_dir = chunk .. "_cache"
+assert(t.mkdir(cache_dir))
+
+--Mirrors chunk_hash() in loader.c to find the generated files
+local function cache_file(src)
+    local prime = 0x100000001b3
+    local hash = 0xcbf29ce484222325
+    local major, minor = _VERSION:match("(%d+)%.(%d+)")
+
+    for i = 1, #chunk do hash = (hash ~ chunk:byte(i)) * prime end
+    hash = (hash ~ (tonumber(major) * 100 + tonumber(minor))) * prime
+    for i = 1, #src do hash = (hash ~ src:byte(i)) * prime end
+
+    return string.format("%s/%016x.luac", cache_dir, hash)
+end
+
+local function write_chunk(src)
+    local f = assert(io.open(chunk, "wb"))
+    f:write(src)
+    f:close()
+end
+
+write_chunk("return 1")
+local ok, hits, misses = t.load_cached(chunk, cache_dir)
+assert(ok)
+
+local ok2, hits2, misses2, errors2 = t.load_cached(chunk, cache_dir)
+assert(ok2)
+u.asserteq(hits2, hits + 1)
+u.asserteq(misses2, misses)
+
+write_chunk("return 2")
+local ok3, hits3, misses3, errors3 = t.load_cached(chunk, cache_dir)
+assert(ok3)
+u.asserteq(hits3, hits2)
+u.asserteq(misses3, misses2 + 1)
+u.asserteq(errors3, errors2)
+
+assert(not t.load_cached(chunk .. ".missing", cache_dir))
+os.remove(chunk)
+
+assert(os.remove(cache_file("return 1")))
+assert(os.remove(cache_file("return 2")))
+assert(t.rmdir(cache_dir))
+
 ecs.progress_cb = function () end
 
 require "entity"
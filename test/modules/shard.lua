@@ -0,0 +1,8 @@
+local ecs = require "ecs"
+
+local frames = 0
+
+ecs.system(function ()
+    frames = frames + 1
+    if frames == 10 then ecs.quit() end
+end, "ShardFrames", ecs.OnUpdate)
@@ -104,3 +104,166 @@ for foo, e in ecs.each(q) do
 end
 
 u.asserteq(q_count, 5)
+
+
+--Reused each() state
+q = ecs.query("Position, Velocity")
+
+for n = 1, 3 do
+    q_count = 0
+    for p, v, e in ecs.each(q) do
+        q_count = q_count + 1
+    end
+    u.asserteq(q_count, 10)
+end
+
+--Nested loops over the same query
+q_count = 0
+for p, e in ecs.each(q) do
+    for p2, e2 in ecs.each(q) do
+        q_count = q_count + 1
+    end
+end
+u.asserteq(q_count, 100)
+
+--Early exit
+for p, v, e in ecs.each(q) do
+    p.x = -1
+    break
+end
+
+q_count = 0
+for p, v, e in ecs.each(q) do
+    q_count = q_count + 1
+end
+u.asserteq(q_count, 10)
+
+--Errors inside the loop release the state
+assert(not pcall(function ()
+    for p, v, e in ecs.each(q) do error("stop") end
+end))
+
+for n = 1, 2 do
+    q_count = 0
+    for p, e in ecs.each(q) do
+        for p2, e2 in ecs.each(q) do
+            q_count = q_count + 1
+            break
+        end
+    end
+    u.asserteq(q_count, 10)
+end
+
+
+--Sorted queries
+local Sorted = ecs.struct("Sorted", "{int32_t pad; float value;}")
+local values = { 5, 3, 9, 1, 7 }
+
+for i, v in ipairs(values) do
+    ecs.set(ecs.new(), Sorted, { pad = i, value = v })
+end
+
+--Different archetype
+ecs.set(ecs.new(nil, "Position"), Sorted, { value = 4 })
+
+q = ecs.query{ expr = "Sorted", order_by = { Sorted, "value" } }
+
+local prev = -math.huge
+q_count = 0
+for s, e in ecs.each(q) do
+    assert(s.value >= prev)
+    prev = s.value
+    q_count = q_count + 1
+end
+u.asserteq(q_count, 6)
+
+q = ecs.query{ expr = "Sorted", order_by = { Sorted, function(e1, s1, e2, s2) return s2.value - s1.value end } }
+
+prev = math.huge
+it = ecs.query_iter(q)
+while ecs.query_next(it) do
+    local s = ecs.columns(it)
+    for i = 1, it.count do
+        assert(s[i].value <= prev)
+        prev = s[i].value
+    end
+end
+
+assert(not pcall(ecs.query, { expr = "Sorted", order_by = { Sorted, "missing" } }))
+
+
+--Grouped queries
+local Zone = ecs.tag("Zone")
+local ZoneA = ecs.new("ZoneA")
+local ZoneB = ecs.new("ZoneB")
+
+for i = 1, 5 do
+    local e = ecs.set(ecs.new(), Position, { x = i, y = i })
+    ecs.add_pair(e, Zone, i <= 3 and ZoneA or ZoneB)
+end
+
+q = ecs.query{ expr = "Position, (Zone, *)", group_by = Zone }
+
+local function group_count(group)
+    local n = 0
+    it = ecs.query_iter(q, { group = group })
+    while ecs.query_next(it) do
+        u.asserteq(it.group_id, group)
+        n = n + it.count
+    end
+    return n
+end
+
+u.asserteq(group_count(ZoneA), 3)
+u.asserteq(group_count(ZoneB), 2)
+u.asserteq(group_count(ecs.new()), 0)
+
+assert(not pcall(ecs.query_iter, ecs.query("Position"), { group = ZoneA }))
+
+
+--Change detection
+local Counter = ecs.struct("Counter", "{int32_t v;}")
+local c1 = ecs.set(ecs.new(), Counter, { v = 1 })
+ecs.set(ecs.new(nil, "Position"), Counter, { v = 2 })
+
+q = ecs.query("[in] Counter")
+
+local function changed_count()
+    local n = 0
+    it = ecs.query_iter(q, { changed = true })
+    while ecs.query_next(it) do
+        assert(it.changed)
+        n = n + it.count
+    end
+    return n
+end
+
+u.asserteq(changed_count(), 2)
+u.asserteq(changed_count(), 0)
+
+ecs.set(c1, Counter, { v = 3 })
+
+it = ecs.query_iter(q)
+local dirty = 0
+while ecs.query_next(it) do
+    if it.changed then dirty = dirty + 1 end
+end
+u.asserteq(dirty, 1)
+
+ecs.set(c1, Counter, { v = 4 })
+
+q_count = 0
+for c, e in ecs.each(q, { changed = true }) do
+    u.asserteq(e, c1)
+    q_count = q_count + 1
+end
+u.asserteq(q_count, 1)
+
+--Iterators keep working after their query becomes unreachable
+it = ecs.query_iter(ecs.query("Position"))
+collectgarbage()
+collectgarbage()
+
+q_count = 0
+while ecs.query_next(it) do q_count = q_count + it.count end
+assert(q_count >= 10)
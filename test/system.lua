@@ -206,3 +206,268 @@ assert(triggered[ecs.OnRemove] > 0)
 
 
 assert(not pcall(function () ecs.observer(observer, "name", ecs.invalid_id, "LuaStruct") end))
+
+--Batched observers
+local batches, records = 0, 0
+
+local function batched(b)
+    batches = batches + 1
+    records = records + b.count
+
+    u.asserteq(#b.entities, b.count)
+    u.asserteq(#b.ids, b.count)
+
+    local n = 0
+    for _, g in ipairs(b.groups) do n = n + g.count end
+    u.asserteq(n, b.count)
+
+    assert(b.events[1] == ecs.OnAdd)
+    assert(b.ids[1] == Struct)
+end
+
+ecs.observer(batched, "batched", ecs.OnAdd, "LuaStruct", { batch = true })
+
+for i = 1, 100 do ecs.add(ecs.new(), Struct) end
+
+u.asserteq(batches, 0)
+ecs.progress(0)
+u.asserteq(batches, 1)
+u.asserteq(records, 100)
+
+ecs.progress(0)
+u.asserteq(batches, 1)
+
+assert(not pcall(ecs.observer, batched, "name", ecs.OnAdd, "LuaStruct", { batch = "yes" }))
+
+--Custom events
+local Hit = ecs.struct("Hit", "{int32_t damage;}")
+local hits, damage, calls = 0, 0, 0
+
+local function on_hit(it)
+    calls = calls + 1
+    hits = hits + it.count
+    damage = damage + it.payload.damage * it.count
+    assert(it.event == Hit)
+end
+
+ecs.observer(on_hit, "OnHit", Hit, "LuaStruct")
+
+local targets = {}
+for i = 1, 5 do targets[i] = ecs.set(ecs.new(), Struct, { v = i }) end
+
+ecs.emit(Hit, Struct, targets, { damage = 3 })
+u.asserteq(hits, 5)
+u.asserteq(damage, 15)
+u.asserteq(calls, 1)
+
+ecs.emit(Hit, { Struct }, targets[1], { damage = 2 })
+u.asserteq(hits, 6)
+u.asserteq(damage, 17)
+
+assert(not pcall(ecs.emit, Hit, Struct, targets, 5))
+assert(not pcall(ecs.emit, ecs.OnAdd, Struct, targets, { damage = 1 }))
+assert(not pcall(ecs.emit, ecs.invalid_id, Struct, targets))
+
+--Payloads with hooks are constructed and finalized
+local Message = ecs.struct("Message", "{char* text; int32_t id;}")
+local texts = {}
+
+local on_message = ecs.observer(function (it) texts[#texts + 1] = it.payload.text or "" end, "OnMessage", Message, "LuaStruct")
+
+ecs.emit(Message, Struct, targets[2], { text = "hello", id = 1 })
+ecs.emit(Message, Struct, targets[2], { id = 2 })
+u.asserteq(texts[1], "hello")
+u.asserteq(#texts, 2)
+
+assert(not pcall(ecs.emit, Message, Struct, targets[2], { text = {} }))
+assert(not pcall(ecs.emit, Message, Struct, { targets[1], "x" }, { text = "leak" }))
+u.asserteq(#texts, 2)
+ecs.delete(on_message)
+
+--Sampling profiler
+local function hot_loop(n)
+    local x = 0
+    for i = 1, n do x = x + i % 7 end
+    return x
+end
+
+local hot = ecs.system(function () hot_loop(100000) end, "HotSystem", ecs.OnUpdate)
+
+ecs.profiler_start({ interval_us = 0, count = 100 })
+assert(not pcall(ecs.profiler_start))
+ecs.progress(0)
+local folded = ecs.profiler_stop()
+
+assert(folded:find("HotSystem;", 1, true))
+assert(folded:find(";hot_loop@", 1, true))
+assert(folded:find(" %d+\n"))
+assert(not pcall(ecs.profiler_stop))
+ecs.delete(hot)
+
+--Tracing
+local traced = ecs.system(function () end, "TracedSystem", ecs.OnUpdate)
+
+ecs.trace_start()
+assert(not pcall(ecs.trace_start))
+ecs.progress(0)
+local json = ecs.trace_stop()
+
+assert(json:find('"name":"TracedSystem","cat":"system"', 1, true))
+assert(json:find('"name":"pcall","cat":"lua"', 1, true))
+
+--Only the last 4 spans are kept
+ecs.trace_start(4)
+ecs.progress(0)
+ecs.progress(0)
+local _, spans = ecs.trace_stop():gsub('"ph":"X"', "")
+u.asserteq(spans, 4)
+assert(not pcall(ecs.trace_stop))
+ecs.delete(traced)
+
+--System groups
+local Counter = ecs.struct("GroupCounter", "{int32_t v;}")
+local group_e = ecs.set(ecs.new(), Counter, { v = 1 })
+local order = {}
+
+local group = ecs.system_group("CounterGroup", ecs.OnUpdate, "GroupCounter", {
+    function (it)
+        order[#order + 1] = 1
+        for i = 1, it.count do it.columns[1][i].v = it.columns[1][i].v * 10 end
+    end,
+    function (it)
+        --Sees the values written by the previous function
+        order[#order + 1] = 2
+        for i = 1, it.count do it.columns[1][i].v = it.columns[1][i].v + 1 end
+    end
+})
+
+ecs.progress(0)
+u.asserteq(ecs.get(group_e, Counter).v, 11)
+u.asserteq(#order, 2)
+u.asserteq(order[1], 1)
+u.asserteq(order[2], 2)
+
+assert(not pcall(ecs.system_group, "Empty", ecs.OnUpdate, "GroupCounter", {}))
+assert(not pcall(ecs.system_group, "Invalid", ecs.OnUpdate, "GroupCounter", { 1 }))
+assert(not pcall(ecs.system, {}, "NotAFunction", ecs.OnUpdate))
+ecs.delete(group)
+
+--Column cache
+local Cached = ecs.struct("CachedValue", "{int32_t v;}")
+local cached_e = ecs.set(ecs.new(), Cached, { v = 1 })
+local col_a, col_b, col_c
+local cache_opts = { cache_columns = true }
+
+local sys_a = ecs.system(function (it) col_a = it.columns[1] end, "CacheA", ecs.OnUpdate, "[in] CachedValue", cache_opts)
+local sys_w = ecs.system(function (it)
+    for i = 1, it.count do it.columns[1][i].v = it.columns[1][i].v + 1 end
+end, "CacheWriter", ecs.OnUpdate, "CachedValue")
+local sys_b = ecs.system(function (it) col_b = it.columns[1] end, "CacheB", ecs.OnUpdate, "[in] CachedValue", cache_opts)
+local sys_c = ecs.system(function (it) col_c = it.columns[1] end, "CacheC", ecs.OnUpdate, "[in] CachedValue", cache_opts)
+
+ecs.progress(0)
+
+--The writer invalidated the column, later readers share the new table
+assert(not rawequal(col_a, col_b))
+assert(rawequal(col_b, col_c))
+u.asserteq(col_a[1].v, 1)
+u.asserteq(col_b[1].v, 2)
+u.asserteq(#col_b, 1)
+
+--Shared columns cannot be modified
+assert(not pcall(function () col_b[1].v = 5 end))
+assert(not pcall(function () col_b[2] = {} end))
+for _, v in pairs(col_b) do u.asserteq(v.v, 2) end
+
+--A new frame starts with an empty cache
+local prev_c = col_c
+ecs.progress(0)
+assert(not rawequal(prev_c, col_a))
+u.asserteq(col_c[1].v, 3)
+
+assert(not pcall(ecs.system, function () end, "BadOpts", ecs.OnUpdate, "CachedValue", 1))
+
+for _, e in ipairs({ sys_a, sys_w, sys_b, sys_c }) do ecs.delete(e) end
+
+--Changed only
+local Watched = ecs.struct("WatchedValue", "{int32_t v;}")
+local watched_e = ecs.set(ecs.new(), Watched, { v = 1 })
+local watched_calls = 0
+
+local watcher = ecs.system(function (it) watched_calls = watched_calls + 1 end,
+    "Watcher", ecs.OnUpdate, "[in] WatchedValue", { changed_only = true })
+
+ecs.progress(0)
+u.asserteq(watched_calls, 1)
+ecs.progress(0)
+u.asserteq(watched_calls, 1)
+
+ecs.set(watched_e, Watched, { v = 2 })
+ecs.progress(0)
+u.asserteq(watched_calls, 2)
+ecs.progress(0)
+u.asserteq(watched_calls, 2)
+
+ecs.delete(watcher)
+
+--Run systems
+local RunValue = ecs.struct("RunValue", "{int32_t v;}")
+local RunTagA = ecs.tag("RunTagA")
+local RunTagB = ecs.tag("RunTagB")
+local run_entities = { ecs.new(), ecs.new(), ecs.new() }
+for _, e in ipairs(run_entities) do ecs.set(e, RunValue, { v = 1 }) end
+ecs.add(run_entities[2], RunTagA)
+ecs.add(run_entities[3], RunTagB)
+local run_calls, run_tables, run_max = 0, 0, nil
+
+local runner = ecs.system(function (it)
+    run_calls = run_calls + 1
+    u.asserteq(it.count, 0)
+
+    while ecs.iter_next(it) do
+        run_tables = run_tables + 1
+        for i = 1, it.count do it.columns[1][i].v = it.columns[1][i].v + 1 end
+        if run_tables == run_max then return end
+    end
+end, "Runner", ecs.OnUpdate, "RunValue", { run = true })
+
+ecs.progress(0)
+u.asserteq(run_calls, 1)
+u.asserteq(run_tables, 3)
+for _, e in ipairs(run_entities) do u.asserteq(ecs.get(e, RunValue).v, 2) end
+
+--Returning early writes back the current table
+run_tables, run_max = 0, 1
+ecs.progress(0)
+u.asserteq(run_calls, 2)
+u.asserteq(run_tables, 1)
+
+local sum = 0
+for _, e in ipairs(run_entities) do sum = sum + ecs.get(e, RunValue).v end
+u.asserteq(sum, 7)
+
+--Never advancing the iterator
+run_max = 0
+local idle = ecs.system(function (it) end, "IdleRunner", ecs.OnUpdate, "RunValue", { run = true })
+ecs.progress(0)
+u.asserteq(run_calls, 3)
+
+ecs.delete(idle)
+ecs.delete(runner)
+
+--Run systems with changed_only skip unchanged tables in ecs.iter_next()
+local changed_tables = 0
+local changed_runner = ecs.system(function (it)
+    while ecs.iter_next(it) do changed_tables = changed_tables + 1 end
+end, "ChangedRunner", ecs.OnUpdate, "[in] RunValue", { run = true, changed_only = true })
+
+ecs.progress(0)
+u.asserteq(changed_tables, 3)
+ecs.progress(0)
+u.asserteq(changed_tables, 3)
+
+ecs.set(run_entities[2], RunValue, { v = 10 })
+ecs.progress(0)
+u.asserteq(changed_tables, 4)
+
+ecs.delete(changed_runner)
@@ -1,6 +1,17 @@
 #define FLECS_LUA_TEST_IMPL
 #include "test.h"
 
+#ifdef _WIN32
+    #include <direct.h>
+    #define test_mkdir(path) _mkdir(path)
+    #define test_rmdir(path) _rmdir(path)
+#else
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define test_mkdir(path) mkdir(path, 0700)
+    #define test_rmdir(path) rmdir(path)
+#endif
+
 ECS_COMPONENT_DECLARE(lua_test_vector);
 
 struct vars
@@ -47,8 +58,50 @@ static void init_globals(void)
     memcpy(&g.s, &s, sizeof(s));
 }
 
+/* load_cached(path, cache_dir) -> ok, hits, misses, errors */
+static int load_cached(lua_State *L)
+{
+    ecs_world_t *w = ecs_lua_get_world(L);
+    const char *path = luaL_checkstring(L, 1);
+    const char *cache_dir = luaL_checkstring(L, 2);
+
+    int ret = ecs_lua_load_cached(w, path, cache_dir);
+    lua_pop(L, 1); /* function or error message */
+
+    ecs_lua_cache_stats_t stats;
+    ecs_lua_cache_stats(w, &stats);
+
+    lua_pushboolean(L, ret == LUA_OK);
+    lua_pushinteger(L, stats.hits);
+    lua_pushinteger(L, stats.misses);
+    lua_pushinteger(L, stats.errors);
+
+    return 4;
+}
+
+static int make_dir(lua_State *L)
+{
+    const char *path = luaL_checkstring(L, 1);
+
+    lua_pushboolean(L, !test_mkdir(path));
+
+    return 1;
+}
+
+static int remove_dir(lua_State *L)
+{
+    const char *path = luaL_checkstring(L, 1);
+
+    lua_pushboolean(L, !test_rmdir(path));
+
+    return 1;
+}
+
 static const luaL_Reg test_lib[] =
 {
+    { "load_cached", load_cached },
+    { "mkdir", make_dir },
+    { "rmdir", remove_dir },
     { "dummy", NULL },
     { NULL, NULL }
 };
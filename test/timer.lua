@@ -57,3 +57,58 @@ assert(system_a_invoked == false)
 ecs.progress(1.0)
 assert(system_a_invoked == true)
 
+
+--Timer wheel
+local fired, ticks = 0, 0
+
+ecs.after(0.5, function () fired = fired + 1 end)
+local cancelled = ecs.after(0.5, function () error("cancelled timer fired") end)
+local every = ecs.every(1, function () ticks = ticks + 1 end)
+local late = ecs.after(3600, function () fired = fired + 100 end)
+
+assert(ecs.cancel(cancelled))
+assert(not ecs.cancel(cancelled))
+
+ecs.progress(0.25)
+u.asserteq(fired, 0)
+ecs.progress(0.25)
+u.asserteq(fired, 1)
+u.asserteq(ticks, 0)
+
+ecs.progress(0.5)
+u.asserteq(ticks, 1)
+ecs.progress(2)
+u.asserteq(ticks, 3)
+
+--Cancel from inside the callback
+local self_cancel = 0
+ecs.every(0.1, function (timer)
+    self_cancel = self_cancel + 1
+    ecs.cancel(timer)
+end)
+
+ecs.progress(1)
+ecs.progress(1)
+u.asserteq(self_cancel, 1)
+
+--The first timer of a world can be added from a system
+local tw = ecs.init()
+assert(not tw.cancel(1))
+
+local from_system = 0
+tw.system(function (it)
+    if from_system == 0 then
+        from_system = -1
+        tw.after(0, function () from_system = 1 end)
+    end
+end, "TimerAdder", tw.OnUpdate)
+
+tw.progress(0.01)
+tw.progress(0.01)
+u.asserteq(from_system, 1)
+tw.fini()
+
+assert(ecs.cancel(every))
+assert(ecs.cancel(late))
+u.asserteq(fired, 1)
+assert(not pcall(ecs.after, -1, function () end))